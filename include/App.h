@@ -0,0 +1,27 @@
+#ifndef APP_H_
+#define APP_H_
+
+#include "BootProfiler.h"
+#include "TractionSound.h"
+#include "Telemetry.h"
+
+// 起動段階 (BootProfilerの表示順)
+enum {
+  BOOT_STAGE_POWER,
+  BOOT_STAGE_DISPLAY,
+  BOOT_STAGE_USB,
+  BOOT_STAGE_MOTOR,
+  BOOT_STAGE_SPEAKER,
+  BOOT_STAGE_FIRST_TICK,
+};
+
+extern BootProfiler boot_profiler;
+extern TractionSound traction_sound;
+extern Telemetry telemetry;
+
+// ハードウェアに依存しないアプリ本体 (デバイスはhal経由で扱う)
+void appSetup();
+void appLoop();
+bool appIsIdle();
+
+#endif //APP_H_
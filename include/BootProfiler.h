@@ -0,0 +1,30 @@
+#ifndef BOOT_PROFILER_H_
+#define BOOT_PROFILER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define BOOT_PROFILER_STAGE_MAX     8
+
+class BootProfiler {
+public:
+    BootProfiler();
+
+    void begin(uint8_t stage, const char *name);
+    void end(uint8_t stage, bool is_ok = true);
+    bool is_done(uint8_t stage);
+    void report();
+
+private:
+    typedef struct {
+        const char *name;
+        uint32_t start_us;
+        uint32_t end_us;
+        bool is_done;
+        bool is_ok;
+    } Stage_t;
+
+    Stage_t stages_[BOOT_PROFILER_STAGE_MAX];
+};
+
+#endif //BOOT_PROFILER_H_
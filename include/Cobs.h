@@ -0,0 +1,31 @@
+#ifndef COBS_H_
+#define COBS_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+// COBSで符号化した長さの上限 (254バイト毎に1バイト増える)
+#define COBS_ENCODED_MAX(len)       ((len) + (len) / 254 + 1)
+
+// 0x00を含まない列に符号化する (区切りの0x00は呼び出し側で付ける)
+static inline size_t cobsEncode(const uint8_t *data, size_t len, uint8_t *out) {
+    size_t code_pos = 0;
+    size_t out_pos = 1;
+    uint8_t code = 1;
+
+    for (size_t i = 0; i < len; i++) {
+        if (data[i] != 0) {
+            out[out_pos++] = data[i];
+            code++;
+        }
+        if (data[i] == 0 || code == 0xFF) {
+            out[code_pos] = code;
+            code_pos = out_pos++;
+            code = 1;
+        }
+    }
+    out[code_pos] = code;
+    return out_pos;
+}
+
+#endif //COBS_H_
@@ -0,0 +1,41 @@
+#ifndef DEFAULT_NOTCH_TABLE_H_
+#define DEFAULT_NOTCH_TABLE_H_
+
+#include "SpeedControl.h"
+
+// 速度制御の初期テーブル (tools/notch_tuner -o で再生成できる)
+static const NotchTable_t DEFAULT_NOTCH_TABLE = {
+  {  // 力行: ノッチ1-5
+    {20, 4, 5},           // ノッチ1: 最大速度20, 基本加速度4, 5ティックに1回加速
+    {45, 4, 3},           // ノッチ2: 最大速度45, 基本加速度4, 3ティックに1回加速
+    {65, 4, 2},           // ノッチ3: 最大速度65, 基本加速度4, 2ティックに1回加速
+    {75, 5, 1},           // ノッチ4: 最大速度75, 基本加速度5, 毎ティック加速
+    {85, 8, 1}            // ノッチ5: 最大速度85, 基本加速度8, 毎ティック加速
+  },
+  {  // ブレーキ1-8 + 非常
+    {4, 1},               // ブレーキ1: 4ティックに1回減速, 減速度1
+    {3, 1},               // ブレーキ2: 3ティックに1回減速, 減速度1
+    {2, 1},               // ブレーキ3: 2ティックに1回減速, 減速度1
+    {1, 1},               // ブレーキ4: 毎ティック減速, 減速度1
+    {1, 2},               // ブレーキ5: 毎ティック減速, 減速度2
+    {1, 5},               // ブレーキ6: 毎ティック減速, 減速度5
+    {1, 9},               // ブレーキ7: 毎ティック減速, 減速度9
+    {1, 15},              // ブレーキ8: 毎ティック減速, 減速度15
+    {1, 30}               // 非常ブレーキ: 毎ティック減速, 減速度30
+  },
+  {  // 環境抵抗
+    {0, 0},               // レベル0: 抵抗なし
+    {1, 30},              // レベル1: 30ティックに1回減速1
+    {1, 25},              // レベル2: 25ティックに1回減速1
+    {1, 20},              // レベル3: 20ティックに1回減速1
+    {1, 16},              // レベル4: 16ティックに1回減速1
+    {1, 13},              // レベル5: 13ティックに1回減速1
+    {1, 10},              // レベル6: 10ティックに1回減速1
+    {1, 8},               // レベル7: 8ティックに1回減速1
+    {1, 6},               // レベル8: 6ティックに1回減速1
+    {1, 4},               // レベル9: 4ティックに1回減速1
+    {1, 2}                // レベル10: 2ティックに1回減速1
+  }
+};
+
+#endif //DEFAULT_NOTCH_TABLE_H_
@@ -0,0 +1,23 @@
+#ifndef EVENT_BUS_H_
+#define EVENT_BUS_H_
+
+// 型ごとのイベント配信
+// 発行側は event::publish() を呼ぶだけで、購読者はアプリ側の1つの翻訳単位で
+// publish<E>() を明示的特殊化し、SubscriberList に並べて登録する。
+// 配信は並べた順の直接呼び出しに展開される (ヒープ・仮想関数なし)
+namespace event {
+
+template <typename E>
+void publish(const E &event);
+
+template <typename E, void (*...Handlers)(const E &)>
+struct SubscriberList {
+    static inline void dispatch(const E &event) {
+        int expand[] = {0, (Handlers(event), 0)...};
+        (void)expand;
+    }
+};
+
+}
+
+#endif //EVENT_BUS_H_
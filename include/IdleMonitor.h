@@ -0,0 +1,36 @@
+#ifndef IDLE_MONITOR_H_
+#define IDLE_MONITOR_H_
+
+#include <stdint.h>
+
+// 停車して操作のない状態が続いたかの判定 (時刻と状態だけで動く状態機械)
+// 待機中の起床は入力側から wake() で知らせる
+class IdleMonitor {
+public:
+    typedef enum {
+        ACTION_NONE,
+        ACTION_ENTER,
+    } Action_t;
+
+    IdleMonitor(uint32_t enter_ms);
+
+    Action_t update(uint32_t now_ms, bool is_quiet);
+    bool wake(uint32_t now_ms);
+
+    bool is_idle();
+    uint32_t idle_since_ms();
+    uint32_t last_idle_ms();
+    uint32_t wake_count();
+
+private:
+    static const uint32_t NOT_QUIET;
+
+    uint32_t enter_ms_;
+    uint32_t quiet_since_ms_;
+    uint32_t idle_since_ms_;
+    uint32_t last_idle_ms_;
+    uint32_t wake_count_;
+    volatile bool is_idle_;
+};
+
+#endif //IDLE_MONITOR_H_
@@ -0,0 +1,82 @@
+#ifndef INPUT_ENGINE_H_
+#define INPUT_ENGINE_H_
+
+#include <stdint.h>
+#include "EventBus.h"
+
+#define INPUT_BUTTON_NUM            16      // ボタン(X) 8bit + 追加ボタン(Y) 8bit
+#define INPUT_CHORD_MAX             4
+#define INPUT_ACTION_NONE           0xFF
+
+typedef enum {
+    INPUT_PRESS,            // 押した時
+    INPUT_LONG_PRESS,       // 押し続けて hold_ms 経った時 (1回)
+    INPUT_REPEAT,           // 押した時と、押し続けている間 repeat_ms 毎
+    INPUT_CHORD,            // mask のボタンが揃って押された時 (1回)
+} InputGesture_t;
+
+typedef struct {
+    InputGesture_t gesture;
+    uint16_t mask;          // 対象のボタン (INPUT_CHORD 以外は1つだけ)
+    uint8_t action;         // InputActionEvent_t で発行する番号
+} InputBinding_t;
+
+typedef struct {
+    uint8_t action;
+    uint32_t time_ms;
+} InputActionEvent_t;
+
+namespace event {
+template <> void publish<InputActionEvent_t>(const InputActionEvent_t &event);
+}
+
+// ボタンのエッジ(時刻つき)から操作を判定する
+// 状態はボタン毎の固定長の表で持ち、1エッジあたりの処理は表の1行と和音の数で決まる。
+// 長押し・リピート・チャタリングの収束は poll() で時刻を進めて判定する
+class InputEngine {
+public:
+    typedef struct {
+        uint16_t debounce_ms;       // 受け付けたエッジからこの間の変化は収まるまで待つ
+        uint16_t hold_ms;
+        uint16_t repeat_delay_ms;   // 最初のリピートまで
+        uint16_t repeat_ms;
+        uint16_t chord_window_ms;   // 和音の最初と最後のボタンを押す間隔の上限
+    } Config_t;
+
+    InputEngine(const InputBinding_t *bindings, uint8_t num, const Config_t &config);
+
+    void edge(uint8_t id, bool is_down, uint32_t time_ms);
+    void poll(uint32_t now_ms);
+    uint16_t pressed();
+
+private:
+    typedef struct {
+        uint32_t edge_ms;           // 最後に受け付けたエッジ
+        uint32_t next_ms;           // 次の長押し・リピートの時刻
+        uint8_t press_action;
+        uint8_t hold_action;
+        bool is_repeat;
+        bool is_raw_down;
+        bool is_settling;           // チャタリングの収束待ち
+        bool is_timer_armed;
+    } ButtonState_t;
+
+    typedef struct {
+        uint16_t mask;
+        uint8_t action;
+        bool is_fired;
+    } Chord_t;
+
+    void accept(uint8_t id, bool is_down, uint32_t time_ms);
+    void checkChords(uint32_t time_ms);
+    void fire(uint8_t action, uint32_t time_ms);
+
+    Config_t config_;
+    ButtonState_t buttons_[INPUT_BUTTON_NUM];
+    Chord_t chords_[INPUT_CHORD_MAX];
+    uint8_t chord_num_;
+    uint16_t pressed_;
+    uint16_t timed_;                // poll() で時刻を見るボタン
+};
+
+#endif //INPUT_ENGINE_H_
@@ -0,0 +1,31 @@
+#ifndef LOCO_PROFILE_H_
+#define LOCO_PROFILE_H_
+
+#include <stdint.h>
+
+#define LOCO_PROFILE_NUM            4
+
+// 車両ごとの出力特性
+typedef struct {
+    uint8_t min_start;      // 動き出すPWM値 (速度1をここに割り当てる)
+    uint8_t kick_level;     // 停止から動き出す時に一瞬だけ出すPWM値 (0で無効)
+    uint8_t kick_frames;    // キックの長さ (出力フレーム数)
+} LocoProfile_t;
+
+typedef struct {
+    uint8_t selected;       // 使用中の車両 (1-LOCO_PROFILE_NUM)
+    LocoProfile_t loco[LOCO_PROFILE_NUM];
+} LocoProfiles_t;
+
+// 初期値はシミュレーターの車両モデル (不感帯12) に合わせてある
+static const LocoProfiles_t DEFAULT_LOCO_PROFILES = {
+  1,
+  {
+    {12, 40, 3},            // 車両1: 12から動き出す, 40を30ms
+    {12, 40, 3},
+    {12, 40, 3},
+    {12, 40, 3}
+  }
+};
+
+#endif //LOCO_PROFILE_H_
@@ -1,7 +1,9 @@
 #ifndef __MASTERCONTROLLER_H__
 #define __MASTERCONTROLLER_H__
 
-#include <usbhid.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "EventBus.h"
 
 #define MASK_HAT                            (0x0F)
 #define IS_BUTTON_DOWN(state, btn)          ((state & btn) ==  btn)
@@ -54,10 +56,31 @@ typedef enum {
     UpLeft = 0x07,
 } HatState_t;
 
-typedef void (*HandleEvent_t)(HandleState_t state);
-typedef void (*HatEvent_t)(HatState_t state);
-typedef void (*ButtonEvent_t)(Button_t button);
-typedef void (*AdditionalButtonEvent_t)(AdditionalButton_t button);
+// ボタン(X)と追加ボタン(Y)を並べた16bit中の位置
+#define BUTTON_BIT(button)                  ((uint16_t)(button))
+#define ADDITIONAL_BUTTON_BIT(button)       ((uint16_t)(button) << 8)
+
+// 変化した時に発行するイベント
+typedef struct {
+    HandleState_t state;
+} HandleChangedEvent_t;
+
+typedef struct {
+    HatState_t state;
+} HatChangedEvent_t;
+
+// ボタン1つの押下・解放 (id は16bit中のビット番号, 時刻はレポートを受けた時刻)
+typedef struct {
+    uint8_t id;
+    bool is_down;
+    uint32_t time_ms;
+} ButtonEdgeEvent_t;
+
+namespace event {
+template <> void publish<HandleChangedEvent_t>(const HandleChangedEvent_t &event);
+template <> void publish<HatChangedEvent_t>(const HatChangedEvent_t &event);
+template <> void publish<ButtonEdgeEvent_t>(const ButtonEdgeEvent_t &event);
+}
 
 struct GamePadEventData {
     uint8_t X, Y, Z1, Z2, Rz;
@@ -66,41 +89,30 @@ struct GamePadEventData {
 class MasterControllerEvents {
 public:
     MasterControllerEvents();
-    void setOnChangedHandle(HandleEvent_t onChangedHandle);
-    void setOnChangedHat(HatEvent_t onChangedHat);
-    void setOnChangedButton(ButtonEvent_t onChangeButton);
-    void setOnChangedAdditionalButton(AdditionalButtonEvent_t setOnChangedAdditionalButton);
 
-    virtual void OnGamePadChanged(const GamePadEventData *evt);
+    virtual void OnGamePadChanged(const GamePadEventData *evt, uint32_t time_ms);
     virtual void OnHatSwitch(uint8_t hat);
-    virtual void OnButtonUp(uint8_t but_id);
-    virtual void OnButtonDn(uint8_t but_id);
+    virtual void OnButtonUp(uint8_t but_id, uint32_t time_ms);
+    virtual void OnButtonDn(uint8_t but_id, uint32_t time_ms);
 
 private:
-    HandleEvent_t onChangedHandle_;
-    HatEvent_t onChangedHat_;
-    ButtonEvent_t onChangedButton_;
-    AdditionalButtonEvent_t onChangedAdditionalButton_;
-
     uint8_t before_handle_;
     uint8_t before_hat_;
-    uint8_t before_button_;
-    uint8_t before_additional_button_;
+    uint16_t before_buttons_;
 };
 
 #define RPT_GEMEPAD_LEN        5
 
-class MasterController : public HIDReportParser {
+class MasterController {
     MasterControllerEvents *joyEvents_;
 
     uint8_t oldPad_[RPT_GEMEPAD_LEN];
     uint8_t oldHat_;
-    uint16_t oldButtons_;
 
 public:
     MasterController(MasterControllerEvents *evt);
 
-    virtual void Parse(USBHID *hid, bool is_rpt_id, uint8_t len, uint8_t *buf);
+    void Parse(uint8_t len, const uint8_t *buf, uint32_t time_ms);
 };
 
 #endif // __MASTERCONTROLLER_H__ 
\ No newline at end of file
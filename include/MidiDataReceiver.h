@@ -1,29 +1,52 @@
 #ifndef MIDI_MANAGER_H_
 #define MIDI_MANAGER_H_
 
-#include <Arduino.h>
-#include <usbh_midi.h>
+#include <stdint.h>
+#include "hal/Hal.h"
+#include "EventBus.h"
 
-typedef void (*NoteOnEvent_t)(bool isOn);
-typedef void (*ControlChangeEvent_t)(uint8_t value);
+typedef enum {
+    MidiPadEmergencyStop,
+    MidiPadSwitchDirection,
+    MidiPadSwitchPoint,
+} MidiPad_t;
+
+typedef enum {
+    MidiControlAccelSize,
+    MidiControlBrakeSize,
+    MidiControlDecelSize,
+    MidiControlMaxSpeed,
+} MidiControl_t;
+
+// PADを叩いた
+typedef struct {
+    MidiPad_t pad;
+} MidiPadEvent_t;
+
+// 鍵盤の加速/ブレーキ
+typedef struct {
+    bool is_accel;
+    bool is_on;
+} MidiKeyEvent_t;
+
+// つまみ
+typedef struct {
+    MidiControl_t control;
+    uint8_t value;
+} MidiControlEvent_t;
+
+namespace event {
+template <> void publish<MidiPadEvent_t>(const MidiPadEvent_t &event);
+template <> void publish<MidiKeyEvent_t>(const MidiKeyEvent_t &event);
+template <> void publish<MidiControlEvent_t>(const MidiControlEvent_t &event);
+}
 
 class MidiDataReceiver {
 public:
-    MidiDataReceiver();
+    MidiDataReceiver(hal::MidiSource *source);
     int8_t init();
     void loop();
 
-    void setOnEmergencyStop(NoteOnEvent_t event);
-    void setOnSwitchDirection(NoteOnEvent_t event);
-    void setOnSwitchPoint(NoteOnEvent_t event);
-    void setOnAccel(NoteOnEvent_t event);
-    void setOnBrake(NoteOnEvent_t event);
-
-    void setOnChangeAccelSize(ControlChangeEvent_t event);
-    void setOnChangeBrakeSize(ControlChangeEvent_t event);
-    void setOnChangeDecelSize(ControlChangeEvent_t event);
-    void setOnChangeMaxSpeed(ControlChangeEvent_t event);
-
 private:
     static const uint8_t kPadChannel;
     static const uint8_t kControlChannel;
@@ -42,19 +65,7 @@ private:
     static const uint8_t kControlNumMaxSpeed;
     
 
-    USB usb_;
-    USBH_MIDI midi_;
-
-    NoteOnEvent_t onEmergencyStop;
-    NoteOnEvent_t onSwitchDirection;
-    NoteOnEvent_t onSwitchPoint;
-
-    NoteOnEvent_t onAccel;
-    NoteOnEvent_t onBrake;
-    ControlChangeEvent_t onChangeAccelSize;
-    ControlChangeEvent_t onChangeBrakeSize;
-    ControlChangeEvent_t onChangeDecelSize;
-    ControlChangeEvent_t onChangeMaxSpeed;
+    hal::MidiSource *source_;
 };
 
 #endif //MIDI_MANAGER_H_
\ No newline at end of file
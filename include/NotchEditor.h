@@ -0,0 +1,52 @@
+#ifndef NOTCH_EDITOR_H_
+#define NOTCH_EDITOR_H_
+
+#include <M5Unified.h>
+#include "SpeedControl.h"
+#include "LocoProfile.h"
+
+class Display;
+
+#define NOTCH_EDITOR_FIELD_MAX      3
+
+class NotchEditor {
+public:
+    NotchEditor(Display *display);
+    void begin(NotchTableStore *tables, LocoProfiles_t *profiles);
+
+    bool update();
+    bool is_active();
+
+private:
+    typedef struct {
+        const char *label;
+        uint8_t *value;
+        uint8_t min;
+        uint8_t max;
+    } Field_t;
+
+    static const uint8_t PAGE_NUM;
+    static const int16_t HEADER_HEIGHT;
+    static const int16_t ROW_TOP;
+    static const int16_t ROW_HEIGHT;
+    static const int16_t FOOTER_HEIGHT;
+    static const int16_t BUTTON_WIDTH;
+
+    void open();
+    void close();
+    uint8_t fields(Field_t *fields);
+    void pageTitle(char *buff, size_t len);
+    void onTouch(int16_t x, int16_t y);
+    void draw();
+
+    NotchTableStore *tables_;
+    LocoProfiles_t *profiles_;
+    Display *display_;
+    NotchTable_t *edit_;
+    LocoProfiles_t loco_edit_;
+    bool is_active_;
+    bool is_dirty_;
+    uint8_t page_;
+};
+
+#endif //NOTCH_EDITOR_H_
@@ -0,0 +1,49 @@
+#ifndef OVERCURRENT_GUARD_H_
+#define OVERCURRENT_GUARD_H_
+
+#include <stdint.h>
+
+// 短絡・過電流の判定 (時刻と電流値だけで動く状態機械)
+// 閾値超えが検出時間続いたら遮断し、待ち時間を倍々に延ばしながら再通電を試す
+class OvercurrentGuard {
+public:
+    typedef enum {
+        STATE_NORMAL,
+        STATE_SUSPECT,      // 閾値超えを検出時間だけ見ている
+        STATE_TRIPPED,      // 遮断して再通電を待っている
+        STATE_RETRY,        // 再通電して安定するか見ている
+    } State_t;
+
+    typedef enum {
+        ACTION_NONE,
+        ACTION_CUT,
+        ACTION_RESTORE,
+    } Action_t;
+
+    typedef struct {
+        uint16_t threshold_ma;
+        uint16_t window_ms;
+        uint16_t stable_ms;         // 再通電後これだけ正常なら復帰とみなす
+        uint32_t backoff_ms;        // 最初の再通電までの待ち
+        uint32_t backoff_max_ms;
+    } Config_t;
+
+    OvercurrentGuard(const Config_t &config);
+
+    Action_t update(uint32_t now_ms, uint16_t current_ma);
+    void reset();
+
+    State_t state();
+    uint32_t backoff_ms();
+    uint32_t trip_count();
+
+private:
+    Config_t config_;
+    State_t state_;
+    uint32_t since_ms_;
+    uint32_t over_since_ms_;
+    uint32_t backoff_ms_;
+    uint32_t trip_count_;
+};
+
+#endif //OVERCURRENT_GUARD_H_
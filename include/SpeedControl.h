@@ -0,0 +1,80 @@
+#ifndef SPEED_CONTROL_H_
+#define SPEED_CONTROL_H_
+
+#include <stdint.h>
+#include <atomic>
+
+#define POWER_NOTCH_NUM             5
+#define BRAKE_NOTCH_NUM             9       // ブレーキ1-8 + 非常
+#define ENV_RESISTANCE_NUM          11
+#define NOTCH_EMERGENCY             (-9)
+#define NOTCH_INVALID               INT8_MIN
+#define SPEED_Q8_SHIFT              8       // 速度の固定小数点 (下位8bitが小数部)
+
+// 力行段階の定義
+typedef struct {
+    uint8_t max_speed;   // 最大速度 (PWM値)
+    uint8_t base_accel;  // 基本加速度 (PWM値)
+    uint8_t period;      // 加速周期 (ティック数)
+} PowerNotchInfo_t;
+
+// ブレーキ段階の定義
+typedef struct {
+    uint8_t period;      // 減速周期 (ティック数)
+    uint8_t decel;       // 減速度 (PWM値/ティック)
+} BrakeNotchInfo_t;
+
+// 環境抵抗の定義
+typedef struct {
+    uint8_t decel;        // 減速量 (PWM値/ティック)
+    uint8_t period;       // 減速周期 (ティック数)
+} EnvironmentResistance_t;
+
+typedef struct {
+    PowerNotchInfo_t power[POWER_NOTCH_NUM];
+    BrakeNotchInfo_t brake[BRAKE_NOTCH_NUM];
+    EnvironmentResistance_t resistance[ENV_RESISTANCE_NUM];
+} NotchTable_t;
+
+// 制御ティックからはロックなしで参照し、編集側は裏面を書き換えてからポインタを切り替える
+// 中身を読む間は acquire() から release() まで面ごとの参照数を増やしておき、
+// 切り替え前の面をまだ読んでいるティックがあれば beginEdit() は NULL を返す (次の操作で再試行する)
+class NotchTableStore {
+public:
+    NotchTableStore(const NotchTable_t &initial);
+
+    const NotchTable_t *active() const;     // 切り替わったかの比較と、編集側の表示用
+    const NotchTable_t *acquire() const;
+    void release(const NotchTable_t *table) const;
+
+    NotchTable_t *beginEdit();
+    void commit();
+
+private:
+    uint8_t indexOf(const NotchTable_t *table) const;
+
+    NotchTable_t buffers_[2];
+    std::atomic<const NotchTable_t *> active_;
+    mutable std::atomic<uint8_t> readers_[2];
+};
+
+class SpeedControl {
+public:
+    SpeedControl(const NotchTableStore *tables);
+
+    bool tick(int8_t notch, uint8_t resistance);
+    int8_t current_speed();
+    uint16_t current_speed_q8();
+    void reset(int8_t speed = 0);
+
+    static uint32_t brakingDistance(const BrakeNotchInfo_t &brake, int8_t speed);
+
+private:
+    void step(const NotchTable_t *table, int8_t notch, uint8_t resistance);
+
+    const NotchTableStore *tables_;
+    int32_t speed_;         // 小数部つき (SPEED_Q8_SHIFT)
+    uint8_t tick_count_;
+};
+
+#endif //SPEED_CONTROL_H_
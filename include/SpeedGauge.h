@@ -0,0 +1,35 @@
+#ifndef SPEED_GAUGE_H_
+#define SPEED_GAUGE_H_
+
+#include <stdint.h>
+
+// 円弧の速度計で描き直す範囲を求める (描画は呼び出し側)
+class SpeedGauge {
+public:
+    typedef struct {
+        float start_deg;
+        float end_deg;
+        bool is_fill;       // true: 速度色で塗る / false: 背景色に戻す
+    } Arc_t;
+
+    static const float START_DEG;
+    static const float RANGE_DEG;
+    static const float END_DEG;
+
+    SpeedGauge();
+    void setMaxSpeed(int8_t max_speed);
+    void setSpeed(int8_t speed);
+    bool nextArc(Arc_t *arc);
+    void invalidate();
+    int8_t speed();
+
+private:
+    static const int8_t SPEED_MIN;
+    static const int8_t SPEED_MAX;
+
+    int8_t max_speed_;
+    int8_t speed_;
+    int8_t drawn_speed_;
+};
+
+#endif //SPEED_GAUGE_H_
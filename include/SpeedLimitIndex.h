@@ -0,0 +1,45 @@
+#ifndef SPEED_LIMIT_INDEX_H_
+#define SPEED_LIMIT_INDEX_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define SPEED_LIMIT_NONE            INT8_MAX
+
+// 制限区間 [start, end) (位置なら速度 x ティック、時刻ならms)
+typedef struct {
+    uint32_t start;
+    uint32_t end;
+    int8_t limit;
+} SpeedLimitZone_t;
+
+// 開始位置順に並んだ重ならない区間表をカーソルで辿る
+// 位置は単調に増える前提なので、1ティックで進むのは高々数区間になる
+// 逆向きは周回を折り返した区間表 (mirror() で作る) に切り替えて、同じく増える向きに辿る
+class SpeedLimitIndex {
+public:
+    SpeedLimitIndex(const SpeedLimitZone_t *zones, uint16_t count, uint32_t period = 0,
+                    const SpeedLimitZone_t *reversed = NULL);
+
+    static void mirror(const SpeedLimitZone_t *zones, uint16_t count, uint32_t period, SpeedLimitZone_t *reversed);
+
+    void reset();
+    bool update(uint32_t position);
+    bool setReversed(bool is_reversed);
+    uint32_t period();
+
+    int8_t limit();
+    int16_t zone();
+    bool nextLimit(int8_t *limit, uint32_t *distance);
+
+private:
+    const SpeedLimitZone_t *forward_;
+    const SpeedLimitZone_t *reversed_;      // NULLなら一方向のみ
+    const SpeedLimitZone_t *zones_;         // 今辿っている方
+    uint16_t count_;
+    uint32_t period_;       // 周回の長さ (0: 周回しない)
+    uint16_t cursor_;
+    uint32_t position_;
+};
+
+#endif //SPEED_LIMIT_INDEX_H_
@@ -0,0 +1,22 @@
+#ifndef SPEED_LIMIT_ZONES_H_
+#define SPEED_LIMIT_ZONES_H_
+
+#include "SpeedLimitIndex.h"
+
+// レイアウトに合わせて書き換える (開始位置順・重なりなし)
+// 位置は原点(Yボタン長押し)から右周りに数えた速度 x ティック、シミュレーターの車両モデルで 1000 ≒ 13cm
+// 下の値はシミュレーター用の例。保安装置は起動時は切で、Xボタンで入れる
+
+// 周回の長さ
+#define SPEED_LIMIT_LAP_LENGTH      20000
+
+static const SpeedLimitZone_t POSITION_ZONES[] = {
+    {3000, 7000, 60},       // 曲線
+    {12000, 15000, 45},     // 駅構内
+};
+
+// 起動からの時刻(ms)による制限 (徐行指示など)
+static const SpeedLimitZone_t *const TIME_ZONES = NULL;
+static const uint16_t TIME_ZONE_NUM = 0;
+
+#endif //SPEED_LIMIT_ZONES_H_
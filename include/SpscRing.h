@@ -0,0 +1,44 @@
+#ifndef SPSC_RING_H_
+#define SPSC_RING_H_
+
+#include <stdint.h>
+#include <atomic>
+
+// 書き込み側と読み出し側が1つずつのロックなしリングバッファ
+// 満杯なら push() は待たずに false を返す (Nは2のべき乗)
+template <typename T, uint16_t N>
+class SpscRing {
+    static_assert(N > 0 && (N & (N - 1)) == 0, "N must be a power of 2");
+
+public:
+    SpscRing(): head_(0), tail_(0) {}
+
+    bool push(const T &item) {
+        uint16_t head = head_.load(std::memory_order_relaxed);
+        if ((uint16_t)(head - tail_.load(std::memory_order_acquire)) >= N) return false;
+
+        items_[head & (N - 1)] = item;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T *item) {
+        uint16_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == head_.load(std::memory_order_acquire)) return false;
+
+        *item = items_[tail & (N - 1)];
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    uint16_t size() const {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+    }
+
+private:
+    T items_[N];
+    std::atomic<uint16_t> head_;
+    std::atomic<uint16_t> tail_;
+};
+
+#endif //SPSC_RING_H_
@@ -0,0 +1,39 @@
+#ifndef STATE_SNAPSHOT_H_
+#define STATE_SNAPSHOT_H_
+
+#include <stdint.h>
+
+#define STATE_SNAPSHOT_MAGIC        0x5A47
+#define STATE_SNAPSHOT_VERSION      1
+
+typedef struct {
+    bool is_left;           // 進行方向 (左周り = 後退)
+    bool is_evacute;        // ポイント (待避線側)
+    uint8_t decel_size;     // 環境抵抗レベル
+} ControllerState_t;
+
+// RTCメモリにそのまま置く形式
+typedef struct {
+    uint16_t magic;
+    uint8_t version;
+    uint8_t flags;
+    uint8_t decel_size;
+    uint8_t reserved;
+    uint16_t crc;
+} StateSnapshot_t;
+
+class StateSnapshot {
+public:
+    static void encode(const ControllerState_t &state, StateSnapshot_t *snapshot);
+    static bool decode(const StateSnapshot_t &snapshot, ControllerState_t *state);
+    static void invalidate(StateSnapshot_t *snapshot);
+
+private:
+    static const uint8_t FLAG_LEFT;
+    static const uint8_t FLAG_EVACUTE;
+    static const uint8_t DECEL_SIZE_MAX;
+
+    static uint16_t checksum(const StateSnapshot_t &snapshot);
+};
+
+#endif //STATE_SNAPSHOT_H_
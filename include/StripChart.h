@@ -0,0 +1,61 @@
+#ifndef STRIP_CHART_H_
+#define STRIP_CHART_H_
+
+#include <M5GFX.h>
+
+#define STRIP_CHART_COLUMNS        240
+
+class StripChart {
+public:
+    typedef struct {
+        int8_t speed_min;
+        int8_t speed_max;
+        int8_t notch;
+        uint8_t resistance;
+    } Column_t;
+
+    StripChart(uint8_t samples_per_column);
+    void begin(int16_t height, int8_t max_speed);
+
+    // 速度制御のティックから呼ぶ (列を溜めるだけで描かない)
+    bool addSample(int8_t speed, int8_t notch, uint8_t resistance);
+    // 画面の更新側 (Display::poll) から呼ぶ
+    bool update(LovyanGFX *dst, int32_t x, int32_t y);
+    void invalidate();
+    void redraw();
+    void push(LovyanGFX *dst, int32_t x, int32_t y);
+
+    uint32_t lastRenderMicros();
+    uint32_t maxRenderMicros();
+
+private:
+    static const int8_t NOTCH_MIN;
+    static const int8_t NOTCH_MAX;
+    static const uint8_t RESISTANCE_MAX;
+    static const uint16_t GRID_INTERVAL;
+
+    int16_t speedToY(int8_t speed);
+    int16_t notchToY(int8_t notch);
+    int16_t resistanceToY(uint8_t resistance);
+    void drawGrid(int16_t x, bool is_marker);
+    void drawColumn(int16_t x, const Column_t &prev, const Column_t &curr);
+    void renderColumn(uint32_t column);
+
+    M5Canvas canvas_;
+    Column_t ring_[STRIP_CHART_COLUMNS];    // n列目は ring_[n % STRIP_CHART_COLUMNS]
+    volatile uint32_t columns_total_;       // 列を書き終えてから進める
+    uint32_t rendered_total_;               // キャンバスに描いた列数
+    bool is_invalid_;
+
+    Column_t pending_;
+    uint8_t pending_samples_;
+    uint8_t samples_per_column_;
+    int8_t max_speed_;
+
+    uint32_t render_us_;            // 前回の転送から描いた列の時間
+    uint32_t last_render_us_;       // 描画 + 転送
+    uint32_t max_render_us_;
+    uint32_t reported_lap_;
+};
+
+#endif //STRIP_CHART_H_
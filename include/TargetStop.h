@@ -0,0 +1,51 @@
+#ifndef TARGET_STOP_H_
+#define TARGET_STOP_H_
+
+#include <stdint.h>
+#include "SpeedControl.h"
+
+#define TARGET_STOP_SPEED_NUM       128
+
+// 定位置停止の支援 (TASC)
+// 距離は「速度(PWM値) x ティック数」で数える。マーカーからの位置を速度の積算で推定し、
+// ブレーキノッチ毎の停止距離表と比べて目標に止まれる最も弱いノッチを求める。
+class TargetStop {
+public:
+    typedef enum {
+        MODE_OFF,
+        MODE_SHOW,          // 推奨ノッチを表示するだけ
+        MODE_APPLY,         // ハンドルより強いブレーキが必要なら推奨ノッチで制御する
+    } Mode_t;
+
+    TargetStop(const NotchTableStore *tables);
+
+    void setMode(Mode_t mode);
+    Mode_t mode();
+    void mark(uint32_t target_distance);
+    void clear();
+
+    int8_t tick(int8_t speed);
+    int8_t apply(int8_t notch);
+
+    bool is_armed();
+    int8_t recommended();
+    uint32_t position();
+    uint32_t target();
+    uint32_t stoppingDistance(int8_t notch, int8_t speed);
+
+private:
+    void rebuild(const NotchTable_t *table);
+
+    const NotchTableStore *tables_;
+    const NotchTable_t *built_;
+    uint32_t distance_[BRAKE_NOTCH_NUM][TARGET_STOP_SPEED_NUM];
+
+    Mode_t mode_;
+    bool is_armed_;
+    bool is_braking_;
+    uint32_t position_;
+    uint32_t target_;
+    int8_t recommended_;
+};
+
+#endif //TARGET_STOP_H_
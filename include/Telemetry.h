@@ -0,0 +1,70 @@
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "hal/Hal.h"
+#include "Cobs.h"
+#include "SpscRing.h"
+
+// フレーム: 0x00, COBS([種別][記録][CRC16(種別+記録, リトルエンディアン)]), 0x00
+// フレームは書ける空きがある時だけ丸ごと書く。hal::log() の行もログのフレームとして同じ経路で送るので、
+// フレームの途中に他のタスクの出力が割り込まない
+#define TELEMETRY_TYPE_TICK         0x01
+#define TELEMETRY_TYPE_LOG          0x02        // 記録はログの文字列 (終端なし)
+#define TELEMETRY_RING_SIZE         64          // 50msティックで3.2秒分
+#define TELEMETRY_LOG_MAX           96
+
+#define TELEMETRY_FLAG_FEEDER_CUT   0x01
+#define TELEMETRY_FLAG_ATP_ENABLED  0x02
+#define TELEMETRY_FLAG_ATP_ACTIVE   0x04        // 保安装置が介入中
+#define TELEMETRY_FLAG_TASC_APPLY   0x08        // 定位置停止が自動で介入中
+#define TELEMETRY_FLAG_EMERGENCY    0x10        // ボタンの非常停止
+#define TELEMETRY_FLAG_DROPPED      0x80        // この記録の前に溢れて捨てた記録がある
+
+// 1ティック分の記録 (このままリトルエンディアンで送る)
+typedef struct __attribute__((packed)) {
+    uint32_t time_ms;
+    uint16_t seq;
+    int8_t speed;
+    int8_t target;          // ノッチが目指す速度 (力行の最大速度, それ以外は0)
+    int8_t allowed;         // 保安装置の許容速度
+    int8_t handle_notch;
+    int8_t notch;           // 保安装置・定位置停止を通した後
+    uint8_t resistance;
+    uint8_t flags;
+    uint16_t current_ma;
+    uint16_t i2c_us;        // 前の記録からのモーターとのやりとりの最長時間
+    int16_t jitter_us;      // ティック周期のずれ
+} TelemetryTick_t;
+
+#define TELEMETRY_PAYLOAD_MAX       (sizeof(TelemetryTick_t) > TELEMETRY_LOG_MAX ? sizeof(TelemetryTick_t) : TELEMETRY_LOG_MAX)
+#define TELEMETRY_FRAME_MAX         (COBS_ENCODED_MAX(1 + TELEMETRY_PAYLOAD_MAX + 2) + 2)
+
+// 制御ティックは push() で積むだけで、送信は低優先度のタスクから drain() で行う
+// (ログも drain() が hal::readLog() から取り出して送るので、制御のタスクはUARTを待たない)
+class Telemetry {
+public:
+    Telemetry(hal::TelemetryPort *port);
+
+    bool push(TelemetryTick_t record);
+    void drain();
+
+    uint32_t dropped();
+
+    static size_t encodeFrame(uint8_t type, const uint8_t *payload, size_t len, uint8_t *out);
+
+private:
+    hal::TelemetryPort *port_;
+    SpscRing<TelemetryTick_t, TELEMETRY_RING_SIZE> ring_;
+    uint16_t seq_;
+    bool is_dropped_;
+    volatile uint32_t dropped_;
+
+    // 空きが足りず書けていないフレーム (drain側だけが触る)
+    uint8_t frame_[TELEMETRY_FRAME_MAX];
+    size_t frame_len_;
+    size_t frame_pos_;
+};
+
+#endif //TELEMETRY_H_
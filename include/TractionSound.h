@@ -0,0 +1,48 @@
+#ifndef TRACTION_SOUND_H_
+#define TRACTION_SOUND_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define TRACTION_SOUND_SAMPLE_RATE      16000
+#define TRACTION_SOUND_BLOCK_SAMPLES    256
+
+class TractionSound {
+public:
+    TractionSound(uint32_t sample_rate = TRACTION_SOUND_SAMPLE_RATE);
+
+    void setState(int8_t speed, int8_t notch);
+    void render(int16_t *buffer, size_t samples);
+
+private:
+    static const uint8_t SINE_TABLE_BITS;
+    static const int32_t FM_DEPTH;
+    static const uint16_t ASYNC_SPEED_MAX;
+    static const uint16_t ASYNC_CARRIER_HZ[9];
+    static const int32_t RELEASE_LEVEL;
+    static const int32_t RELEASE_DECAY_Q15;
+
+    uint32_t hzToIncrement(uint32_t hz_x16);
+    uint32_t carrierHz16(int8_t speed);
+    int32_t whineLevel(int8_t speed, int8_t notch);
+    int16_t nextNoise();
+
+    int16_t sine_[256];
+    int16_t hum_wave_[256];
+    uint32_t sample_rate_;
+
+    volatile int8_t speed_;
+    volatile int8_t notch_;
+    int8_t before_notch_;
+
+    uint32_t phase_carrier_;
+    uint32_t phase_motor_;
+    uint32_t inc_carrier_;
+    uint32_t inc_motor_;
+    int32_t level_whine_;
+    int32_t level_hum_;
+    int32_t level_release_;
+    uint16_t lfsr_;
+};
+
+#endif //TRACTION_SOUND_H_
@@ -1,36 +1,58 @@
 #ifndef TRAIN_CONTROLLER_H_
 #define TRAIN_CONTROLLER_H_
 
-#include <Arduino.h>
-#include <M5Module4EncoderMotor.h>
+#include <stdint.h>
+#include "hal/Hal.h"
+#include "LocoProfile.h"
 
 class TrainController {
 public:
-    TrainController();
-    void begin();
+    TrainController(hal::MotorPort *port, const LocoProfiles_t *profiles = NULL);
+    void restore(bool run_back, bool is_waiting_line);
+    bool begin(uint32_t timeout_ms, bool output_point = true);
+    bool is_available();
     bool is_running();
     bool run_back();
     bool is_waiting_lien();
     int8_t current_speed();
     void setSpeed(int8_t speed);
+    void setSpeedQ8(uint16_t speed_q8);
     void accelSpeed(int8_t speed);
     void brakeSpeed(int8_t speed);
     void switchPoint();
     void setPointState(bool is_wating_line);
     void switchDirection();
     void setRunBack(bool run_back);
+    void cutFeeder();
+    void restoreFeeder();
+    bool is_feeder_cut();
+    bool is_switching();
+    void service();
     
 private:
     static const uint8_t IDX_SPEED;
     static const uint8_t IDX_POINT_LEFT;
     static const uint8_t IDX_POINT_RIGHT;
+    static const uint32_t PROBE_INTERVAL_MS;
+    static const LocoProfile_t NO_PROFILE;
 
     void outputSwitch();
+    const LocoProfile_t &profile();
+    static uint16_t outputLevel(uint16_t speed_q8, const LocoProfile_t &profile);
 
-    M5Module4EncoderMotor driver_;
+    hal::MotorPort *port_;
+    const LocoProfiles_t *profiles_;
+    volatile bool is_available_;
+    volatile bool is_feeder_cut_;
+    volatile bool is_switching_;
     bool is_waiting_line_;
     bool run_back_;
-    int8_t speed_;
+    volatile uint16_t speed_q8_;    // 下位8bitが小数部
+    int8_t output_;
+    // ここから下は service() (出力タスク) だけが触る
+    uint16_t last_speed_q8_;
+    uint16_t dither_acc_;
+    uint8_t kick_remain_;
 };
 
 #endif //TRAIN_CONTROLLER_H_
\ No newline at end of file
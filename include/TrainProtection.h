@@ -0,0 +1,62 @@
+#ifndef TRAIN_PROTECTION_H_
+#define TRAIN_PROTECTION_H_
+
+#include <stdint.h>
+#include "SpeedControl.h"
+#include "SpeedLimitIndex.h"
+
+#define TRAIN_PROTECTION_SPEED_NUM  128
+#define TRAIN_PROTECTION_NOTCH_FREE POWER_NOTCH_NUM     // 介入なし (ハンドル通り)
+
+// 速度制限区間による保安装置 (ATS/ATC相当)
+// 推定位置の区間制限と、次の低い制限区間へのブレーキ曲線から許容速度を求め、
+// 超過量に応じて力行遮断から非常ブレーキまで段階的に介入する
+class TrainProtection {
+public:
+    TrainProtection(const NotchTableStore *tables, SpeedLimitIndex *position_zones, SpeedLimitIndex *time_zones);
+
+    void setEnabled(bool is_enabled);
+    bool is_enabled();
+    void setMaxSpeed(int8_t max_speed);
+    void setReversed(bool is_reversed);
+    void resetPosition();
+
+    int8_t tick(int8_t speed, uint32_t time_ms);
+    int8_t apply(int8_t notch);
+
+    int8_t allowed_speed();
+    int8_t intervention();
+    uint32_t position();
+    uint32_t intervention_count();
+
+private:
+    typedef struct {
+        int8_t overspeed;
+        int8_t notch;
+    } Step_t;
+
+    static const Step_t STEPS[];
+    static const uint8_t STEP_NUM;
+    static const uint8_t SERVICE_BRAKE;
+    static const int8_t RELEASE_MARGIN;
+
+    void rebuild(const NotchTable_t *table);
+    int8_t curveSpeed(int8_t limit, uint32_t distance);
+    void log(int8_t speed, int8_t notch);
+
+    const NotchTableStore *tables_;
+    const NotchTable_t *built_;
+    uint32_t curve_[TRAIN_PROTECTION_SPEED_NUM];    // 常用ブレーキでの停止距離
+
+    SpeedLimitIndex *position_zones_;
+    SpeedLimitIndex *time_zones_;
+    bool is_enabled_;
+    bool is_reversed_;
+    int8_t max_speed_;
+    uint32_t position_;     // 今の進行方向で原点から進んだ距離
+    int8_t allowed_speed_;
+    int8_t intervention_;
+    uint32_t intervention_count_;
+};
+
+#endif //TRAIN_PROTECTION_H_
@@ -3,28 +3,41 @@
 
 #include <M5Unified.h>
 #include <M5GFX.h>
+#include "StripChart.h"
+#include "NotchEditor.h"
+#include "SpeedGauge.h"
+#include "hal/Hal.h"
 
-class Display {
+class Display : public hal::DisplaySurface {
 public:
-    Display(int8_t max_speed = 127);
-    void begin();
+    Display();
+    virtual void begin(int8_t max_speed, NotchTableStore *tables, LocoProfiles_t *profiles);
 
-    void setSpeed(int8_t speed, bool is_push = false);
-    void drawRail(bool is_left, bool is_evacute, bool is_push = false);
-    void drawDamp(uint8_t damp);
+    virtual void setSpeed(int8_t speed, bool is_push = false);
+    virtual void drawRail(bool is_left, bool is_evacute, bool is_push = false);
+    virtual void drawDamp(uint8_t damp);
+    virtual void drawTargetStop(bool is_visible, bool is_apply, int8_t notch, uint8_t progress);
+    virtual void addChartSample(int8_t speed, int8_t notch, uint8_t damp);
+    virtual void setChartVisible(bool is_visible);
+    virtual bool is_chart_visible();
+    virtual void poll();
+    void setSuspended(bool is_suspended);
+    LovyanGFX *gfx();
 
 private:
-    static const float SPEED_START_DEG;
-    static const float SPEED_RANGE_DEG;
-    static const float SPEED_END_DEG;
-    static const int8_t SPEED_MIN;
-    static const int8_t SPEED_MAX;
-    int8_t max_speed_;
-    M5GFX display_;
+    static const int16_t PANEL_HEIGHT;
+    static const uint8_t CHART_SAMPLES_PER_COLUMN;
+    M5GFX &display_;
     M5Canvas canvas_speed_;
     M5Canvas canvas_rail_;
     M5Canvas canvas_damp_;
-    int8_t before_speed_;
+    M5Canvas canvas_assist_;
+    SpeedGauge gauge_;
+    StripChart chart_;
+    NotchEditor editor_;
+    bool is_chart_visible_;
+    bool is_suspended_;
+    bool is_assist_visible_;
 };
 
 #endif //DISPLAY_H_
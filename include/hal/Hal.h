@@ -0,0 +1,129 @@
+#ifndef HAL_H_
+#define HAL_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "LocoProfile.h"
+
+class NotchTableStore;
+
+// 実装はビルド環境ごとに src/hal/esp32 または src/hal/posix (+ sim) から1つだけリンクする
+namespace hal {
+
+// 時刻
+uint32_t millis();
+uint32_t micros();
+void delayMs(uint32_t ms);
+void log(const char *format, ...);
+// テレメトリのビルドでは log() はシリアルに書かずに溜めるだけで、テレメトリがここから取り出して送る
+size_t readLog(char *line, size_t size);
+
+// タスク
+typedef void (*TaskProc_t)(void *param);
+
+bool startTask(const char *name, TaskProc_t proc, void *param, uint8_t priority, uint32_t stack_size = 4096);
+
+class Signal {
+public:
+    Signal();
+    void post();
+    bool wait(uint32_t timeout_ms);
+
+private:
+    void *handle_;
+};
+
+// 周期タイマーで起床し、周期ごとにprocを1回呼ぶタスク
+class PeriodicTask {
+public:
+    PeriodicTask(const char *name, uint32_t period_ms, TaskProc_t proc, void *param, uint8_t priority, uint32_t stack_size = 4096);
+    bool start();
+    void stop();
+    void trigger();         // 周期を待たずに1回呼ぶ
+    bool is_running();
+
+private:
+    const char *name_;
+    uint32_t period_ms_;
+    TaskProc_t proc_;
+    void *param_;
+    uint8_t priority_;
+    uint32_t stack_size_;
+    bool is_running_;
+    void *timer_;
+    void *queue_;
+    void *task_;
+
+    static void taskProc(void *param);
+    static void timerProc(void *timer);
+};
+
+// リセットを跨いで保持されるメモリ
+bool isWarmReset();
+void *retainedMemory(size_t size);
+
+// 電源
+void setPowerSave(bool is_enabled);             // 待機中はCPUクロックを落とす (対応ビルドでは自動ライトスリープ)
+bool readBatteryCurrent(int32_t *milliamps);    // 電池から流れ出る向きが負
+
+// デバイス
+class MotorPort {
+public:
+    virtual ~MotorPort() {}
+    virtual bool begin() = 0;
+    virtual bool getFirmwareVersion(uint8_t *version) = 0;
+    virtual uint8_t getAddress() = 0;
+    virtual bool setNormalMode(uint8_t channel) = 0;
+    virtual bool setMotorSpeed(uint8_t channel, int8_t duty) = 0;
+    virtual bool readCurrent(uint16_t *milliamps) = 0;     // モジュール全体の電流
+};
+
+typedef void (*HidReportHandler_t)(uint8_t len, const uint8_t *buf);
+
+class HidSource {
+public:
+    virtual ~HidSource() {}
+    virtual bool begin(HidReportHandler_t handler) = 0;
+    virtual void poll() = 0;
+};
+
+class MidiSource {
+public:
+    virtual ~MidiSource() {}
+    virtual bool begin() = 0;
+    virtual bool is_connected() = 0;
+    virtual bool read(uint8_t *buffer, uint16_t *size) = 0;
+};
+
+class DisplaySurface {
+public:
+    virtual ~DisplaySurface() {}
+    virtual void begin(int8_t max_speed, NotchTableStore *tables, LocoProfiles_t *profiles) = 0;
+    virtual void setSpeed(int8_t speed, bool is_push = false) = 0;
+    virtual void drawRail(bool is_left, bool is_evacute, bool is_push = false) = 0;
+    virtual void drawDamp(uint8_t damp) = 0;
+    virtual void drawTargetStop(bool is_visible, bool is_apply, int8_t notch, uint8_t progress) = 0;
+    virtual void addChartSample(int8_t speed, int8_t notch, uint8_t damp) = 0;
+    virtual void setChartVisible(bool is_visible) = 0;
+    virtual bool is_chart_visible() = 0;
+    virtual void poll() = 0;
+};
+
+// テレメトリの送信先 (書ける分だけ書き、空きを待たない)
+class TelemetryPort {
+public:
+    virtual ~TelemetryPort() {}
+    virtual bool is_enabled() = 0;
+    virtual size_t writable() = 0;
+    virtual size_t write(const uint8_t *data, size_t len) = 0;
+};
+
+MotorPort &motorPort();
+HidSource &hidSource();
+MidiSource &midiSource();
+DisplaySurface &displaySurface();
+TelemetryPort &telemetryPort();
+
+}
+
+#endif //HAL_H_
@@ -0,0 +1,19 @@
+#ifndef POSIX_HAL_H_
+#define POSIX_HAL_H_
+
+#include <stdint.h>
+
+// POSIXバックエンド専用: 仮想時刻を進めて周期タスクを実行する
+namespace hal {
+namespace posix {
+
+uint64_t now_us();
+void advance(uint64_t us);
+void setWarmReset(bool is_warm_reset);
+void setLogEnabled(bool is_enabled);
+uint64_t powerSaveUs();
+
+}
+}
+
+#endif //POSIX_HAL_H_
@@ -0,0 +1,712 @@
+#include <atomic>
+#include "App.h"
+#include "hal/Hal.h"
+#include "TrainController.h"
+#include "MasterController.h"
+#include "MidiDataReceiver.h"
+#include "EventBus.h"
+#include "InputEngine.h"
+#include "IdleMonitor.h"
+#include "SpeedControl.h"
+#include "StateSnapshot.h"
+#include "TargetStop.h"
+#include "TrainProtection.h"
+#include "SpeedLimitZones.h"
+#include "OvercurrentGuard.h"
+#include "DefaultNotchTable.h"
+#include "LocoProfile.h"
+#include "Telemetry.h"
+
+MasterControllerEvents masconEvents;
+MasterController masscon(&masconEvents);
+
+static const uint8_t SPEED_LIMIT = 85;
+
+static const uint32_t TICK_PERIOD_UPDATE_SPEED_MS = 50;
+static const uint32_t UI_POLL_INTERVAL_MS = 20;
+
+static const uint32_t MOTOR_PROBE_TIMEOUT_MS = 300;
+static const uint32_t MOTOR_BOOT_TIMEOUT_MS = 1000;
+static const uint32_t MOTOR_RETRY_INTERVAL_MS = 1000;
+
+// マーカーから停止目標までの距離 (速度 x ティック, シミュレーターの車両モデルで約77cm)
+static const uint32_t TARGET_STOP_DISTANCE = 6000;
+static const uint8_t TARGET_STOP_PROGRESS_STEP = 5;
+
+// 短絡検出は速度制御とは別の周期で電流を見る
+static const uint32_t CURRENT_SAMPLE_PERIOD_MS = 5;
+static const OvercurrentGuard::Config_t OVERCURRENT_CONFIG = {
+  800,      // 閾値 (mA)
+  20,       // 閾値超えがこれだけ続いたら遮断 (ms)
+  1000,     // 再通電後これだけ正常なら復帰 (ms)
+  500,      // 最初の再通電までの待ち (ms)
+  8000,     // 待ちの上限 (ms)
+};
+
+// ディザの1フレーム (I2Cへの速度の書き込みは最大でこの周期に1回)
+static const uint32_t OUTPUT_FRAME_PERIOD_MS = 10;
+
+// 停車・ブレーキ位置のまま操作がなければ周期タスクを止めて待機する
+static const uint32_t IDLE_ENTER_MS = 5000;
+static const uint32_t IDLE_LOOP_DELAY_MS = 10;              // 待機中のHID確認間隔 (起床は1ティック以内)
+static const uint32_t IDLE_CURRENT_SETTLE_MS = 2000;        // 待機に入ってから電流を測るまで
+
+// テレメトリの送信 (1回でUARTの送信FIFOに入る分だけ書く)
+static const uint32_t TELEMETRY_DRAIN_PERIOD_MS = 20;
+
+// マスコンのボタン操作の割り当て
+typedef enum {
+  ACTION_TARGET_STOP_MARK,
+  ACTION_TARGET_STOP_MODE,
+  ACTION_ATP_TOGGLE,
+  ACTION_ATP_ORIGIN,
+  ACTION_CAB_LEFT,
+  ACTION_CAB_RIGHT,
+  ACTION_EMERGENCY_STOP,
+  ACTION_RESISTANCE_UP,
+  ACTION_RESISTANCE_DOWN,
+  ACTION_RESISTANCE_RESET,
+  ACTION_CHART_TOGGLE,
+} InputAction_t;
+
+static const char *const INPUT_ACTION_NAMES[] = {
+  "target stop mark", "target stop mode", "atp toggle", "atp origin", "cab left", "cab right",
+  "emergency stop", "resistance up", "resistance down", "resistance reset", "chart toggle",
+};
+
+static const InputBinding_t INPUT_BINDINGS[] = {
+  {INPUT_PRESS, BUTTON_BIT(AButton), ACTION_TARGET_STOP_MARK},
+  {INPUT_PRESS, BUTTON_BIT(BButton), ACTION_TARGET_STOP_MODE},
+  {INPUT_PRESS, BUTTON_BIT(XButton), ACTION_ATP_TOGGLE},
+  {INPUT_LONG_PRESS, BUTTON_BIT(YButton), ACTION_ATP_ORIGIN},   // 誤操作で原点がずれないよう長押し
+  {INPUT_PRESS, BUTTON_BIT(LButton), ACTION_CAB_LEFT},
+  {INPUT_PRESS, BUTTON_BIT(RButton), ACTION_CAB_RIGHT},
+  {INPUT_CHORD, BUTTON_BIT(ZLButton) | BUTTON_BIT(ZRButton), ACTION_EMERGENCY_STOP},
+  {INPUT_REPEAT, ADDITIONAL_BUTTON_BIT(Plus), ACTION_RESISTANCE_UP},
+  {INPUT_REPEAT, ADDITIONAL_BUTTON_BIT(Minus), ACTION_RESISTANCE_DOWN},
+  {INPUT_PRESS, ADDITIONAL_BUTTON_BIT(Home), ACTION_RESISTANCE_RESET},
+  {INPUT_PRESS, ADDITIONAL_BUTTON_BIT(Camera), ACTION_CHART_TOGGLE},
+};
+
+static const InputEngine::Config_t INPUT_CONFIG = {
+  20,       // チャタリングの収束待ち (ms)
+  1000,     // 長押し (ms)
+  500,      // 最初のリピートまで (ms)
+  150,      // リピート間隔 (ms)
+  200,      // 和音とみなす押下のずれ (ms)
+};
+
+static void onTickUpdateSpeed(void *param);
+static void onTickSampleCurrent(void *param);
+static void onTickOutput(void *param);
+static void onTickTelemetry(void *param);
+
+LocoProfiles_t loco_profiles = DEFAULT_LOCO_PROFILES;
+TrainController train_controller(&hal::motorPort(), &loco_profiles);
+NotchTableStore notch_tables(DEFAULT_NOTCH_TABLE);
+SpeedControl speed_control(&notch_tables);
+TargetStop target_stop(&notch_tables);
+static SpeedLimitZone_t reversed_position_zones[sizeof(POSITION_ZONES) / sizeof(POSITION_ZONES[0])];   // 起動時に作る
+SpeedLimitIndex position_zones(POSITION_ZONES, sizeof(POSITION_ZONES) / sizeof(POSITION_ZONES[0]), SPEED_LIMIT_LAP_LENGTH, reversed_position_zones);
+SpeedLimitIndex time_zones(TIME_ZONES, TIME_ZONE_NUM);
+TrainProtection train_protection(&notch_tables, &position_zones, &time_zones);
+OvercurrentGuard overcurrent_guard(OVERCURRENT_CONFIG);
+IdleMonitor idle_monitor(IDLE_ENTER_MS);
+InputEngine input_engine(INPUT_BINDINGS, sizeof(INPUT_BINDINGS) / sizeof(INPUT_BINDINGS[0]), INPUT_CONFIG);
+MidiDataReceiver midi_receiver(&hal::midiSource());
+Telemetry telemetry(&hal::telemetryPort());
+BootProfiler boot_profiler;
+TractionSound traction_sound;
+
+// 制御のタスクは音声のタスク(2, main.cpp)より上に置く
+static hal::PeriodicTask speed_task("speed control task", TICK_PERIOD_UPDATE_SPEED_MS, onTickUpdateSpeed, NULL, 3);
+static hal::PeriodicTask current_task("current monitor task", CURRENT_SAMPLE_PERIOD_MS, onTickSampleCurrent, NULL, 5);
+static hal::PeriodicTask output_task("motor output task", OUTPUT_FRAME_PERIOD_MS, onTickOutput, NULL, 4);
+static hal::PeriodicTask telemetry_task("telemetry task", TELEMETRY_DRAIN_PERIOD_MS, onTickTelemetry, NULL, 0);
+static hal::Signal motor_ready;
+static hal::DisplaySurface &display = hal::displaySurface();
+
+static uint8_t decelSize = 0;
+static HandleState_t handle_state = Center;  // ハンドル状態の追加
+
+static bool is_left = false;
+static bool is_evacute = false;
+static volatile bool is_mark_requested = false;
+static volatile bool is_emergency_latched = false;
+static volatile bool is_wake_pending = false;
+static volatile uint32_t wake_edge_ms = 0;
+static volatile bool is_origin_requested = false;
+
+// テレメトリ用に電流監視・出力タスクから集める値
+static volatile uint16_t last_current_ma = 0;
+static std::atomic<uint16_t> i2c_max_us(0);     // 電流監視と出力の両タスクが書き、速度のタスクが読んで0に戻す
+
+// リセット後も保持される状態 (電源投入時は不定なのでCRCで検証する)
+static StateSnapshot_t *rtc_snapshot = NULL;
+static bool is_warm_boot = false;
+
+// ハンドル位置をノッチ番号に変換 (力行: 1-5, ブレーキ: -1〜-8, 非常: -9, 中立: 0)
+static int8_t notchFromHandle(HandleState_t handle)
+{
+  switch (handle) {
+    case Power5: return 5;
+    case Power4: return 4;
+    case Power3: return 3;
+    case Power2: return 2;
+    case Power1: return 1;
+    case Brake1: return -1;
+    case Brake2: return -2;
+    case Brake3: return -3;
+    case Brake4: return -4;
+    case Brake5: return -5;
+    case Brake6: return -6;
+    case Brake7: return -7;
+    case Brake8: return -8;
+    case EmergencyBrake: return NOTCH_EMERGENCY;
+    case Center: return 0;
+    default: return NOTCH_INVALID;
+  }
+}
+
+static void saveSnapshot()
+{
+  if (rtc_snapshot == NULL) return;
+
+  // 8バイトの書き込みとCRC計算だけなので変更のたびに更新する
+  ControllerState_t state = {is_left, is_evacute, decelSize};
+  StateSnapshot::encode(state, rtc_snapshot);
+}
+
+static bool restoreSnapshot()
+{
+  if (rtc_snapshot == NULL || !hal::isWarmReset()) return false;
+
+  ControllerState_t state;
+  if (!StateSnapshot::decode(*rtc_snapshot, &state)) return false;
+
+  is_left = state.is_left;
+  is_evacute = state.is_evacute;
+  decelSize = state.decel_size;
+  train_controller.restore(is_left, is_evacute);
+  train_protection.setReversed(is_left);
+  hal::log("warm boot: left %d / evacute %d / decel %d\n", is_left, is_evacute, decelSize);
+  return true;
+}
+
+static void onChangedHandle(const HandleChangedEvent_t &event)
+{
+  handle_state = event.state;  // ハンドル状態の更新
+
+  // ボタンでかけた非常ブレーキはハンドルを非常位置にすると解除する
+  if (handle_state == EmergencyBrake && is_emergency_latched) {
+    is_emergency_latched = false;
+    hal::log("emergency stop: released by handle\n");
+  }
+}
+
+// 運転台(進行方向)の切り替えは停車中のみ
+static void selectCab(bool is_left_cab)
+{
+  if (train_controller.is_running()) return;
+
+  is_left = is_left_cab;
+  train_controller.setRunBack(is_left_cab);
+  train_protection.setReversed(is_left_cab);
+}
+
+static void onChangedHat(const HatChangedEvent_t &event)
+{
+  HatState_t hat = event.state;
+
+  if (train_controller.is_running()) {
+    return;
+  }
+
+  if (hat == UpLeft || hat == Left || hat == DownLeft)
+  {
+    selectCab(true);
+  }
+  else if (hat == DownRight || hat == Right || hat == UpRight)
+  {
+    selectCab(false);
+  }
+
+  if (hat == UpRight || hat == Up || hat == UpLeft)
+  {
+    is_evacute = true;
+    train_controller.setPointState(true);
+  }
+  else if (hat == DownLeft || hat == Down || hat == DownRight)
+  {
+    is_evacute = false;
+    train_controller.setPointState(false);
+  }
+}
+
+static void onInputAction(const InputActionEvent_t &event)
+{
+  switch (event.action) {
+    // 停止目標のマーカー (ここから目標までの距離を数え始める)
+    case ACTION_TARGET_STOP_MARK:
+      is_mark_requested = true;
+      break;
+
+    // 定位置停止 切 -> 案内 -> 自動
+    case ACTION_TARGET_STOP_MODE:
+      switch (target_stop.mode()) {
+        case TargetStop::MODE_OFF: target_stop.setMode(TargetStop::MODE_SHOW); break;
+        case TargetStop::MODE_SHOW: target_stop.setMode(TargetStop::MODE_APPLY); break;
+        default: target_stop.setMode(TargetStop::MODE_OFF); break;
+      }
+      break;
+
+    case ACTION_ATP_TOGGLE:
+      train_protection.setEnabled(!train_protection.is_enabled());
+      hal::log("atp: %s\n", train_protection.is_enabled() ? "on" : "off");
+      break;
+
+    // 今の位置を周回の原点にする
+    case ACTION_ATP_ORIGIN:
+      is_origin_requested = true;
+      break;
+
+    case ACTION_CAB_LEFT:
+      selectCab(true);
+      break;
+
+    case ACTION_CAB_RIGHT:
+      selectCab(false);
+      break;
+
+    // ハンドルを非常位置にするまで非常ブレーキをかけ続ける
+    case ACTION_EMERGENCY_STOP:
+      is_emergency_latched = handle_state != EmergencyBrake;
+      break;
+
+    case ACTION_RESISTANCE_UP:
+      if (decelSize < 10) decelSize++;
+      break;
+
+    case ACTION_RESISTANCE_DOWN:
+      if (decelSize > 0) decelSize--;
+      break;
+
+    case ACTION_RESISTANCE_RESET:
+      decelSize = 0;
+      break;
+
+    case ACTION_CHART_TOGGLE:
+      display.setChartVisible(!display.is_chart_visible());
+      break;
+
+    default:
+      break;
+  }
+}
+
+static void logInputAction(const InputActionEvent_t &event)
+{
+  if (event.action >= sizeof(INPUT_ACTION_NAMES) / sizeof(INPUT_ACTION_NAMES[0])) return;
+  hal::log("input: %s\n", INPUT_ACTION_NAMES[event.action]);
+}
+
+static void onButtonEdge(const ButtonEdgeEvent_t &event)
+{
+  input_engine.edge(event.id, event.is_down, event.time_ms);
+}
+
+static void updateTargetStop(int8_t speed)
+{
+  static bool is_visible = false;
+  static bool is_apply = false;
+  static int8_t notch = 0;
+  static uint8_t progress = 0;
+
+  // マーカーの指示はティック側で受けて、推定中の値と競合しないようにする
+  if (is_mark_requested) {
+    is_mark_requested = false;
+    target_stop.mark(TARGET_STOP_DISTANCE);
+  }
+  target_stop.tick(speed);
+
+  bool next_visible = target_stop.mode() != TargetStop::MODE_OFF && target_stop.is_armed();
+  bool next_apply = target_stop.mode() == TargetStop::MODE_APPLY;
+  uint32_t position = target_stop.position() < target_stop.target() ? target_stop.position() : target_stop.target();
+  uint8_t next_progress = target_stop.target() > 0 ? position * 100 / target_stop.target() : 0;
+  next_progress -= next_progress % TARGET_STOP_PROGRESS_STEP;
+
+  if (next_visible != is_visible || next_apply != is_apply || target_stop.recommended() != notch || next_progress != progress) {
+    is_visible = next_visible;
+    is_apply = next_apply;
+    notch = target_stop.recommended();
+    progress = next_progress;
+    display.drawTargetStop(is_visible, is_apply, notch, progress);
+  }
+}
+
+static void updateProtection(int8_t speed)
+{
+  if (is_origin_requested) {
+    is_origin_requested = false;
+    train_protection.resetPosition();
+  }
+
+  train_protection.tick(speed, hal::millis());
+}
+
+// 表示と音は整数の速度、モーターには小数部ごと渡す
+static void applySpeed(uint16_t speed_q8, int8_t notch)
+{
+  int8_t speed = speed_q8 >> SPEED_Q8_SHIFT;
+  display.setSpeed(speed, true);
+  display.addChartSample(speed, notch, decelSize);
+  traction_sound.setState(speed, notch);
+  train_controller.setSpeedQ8(speed_q8);
+}
+
+// モーターとのI2Cのやりとりにかかった時間の最大値を記録する
+// 他のタスクが間に書いた値や0に戻したのを失わないよう、比較と書き込みは1つの交換で行う
+static void recordI2cTime(uint32_t start_us)
+{
+  uint32_t elapsed_us = hal::micros() - start_us;
+  if (elapsed_us > UINT16_MAX) elapsed_us = UINT16_MAX;
+
+  uint16_t max_us = i2c_max_us.load();
+  while (elapsed_us > max_us && !i2c_max_us.compare_exchange_weak(max_us, (uint16_t)elapsed_us)) {
+  }
+}
+
+static void pushTelemetry(int8_t handle_notch, int8_t tasc_notch, int8_t notch, int32_t jitter_us)
+{
+  TelemetryTick_t record = {};
+  int8_t speed = speed_control.current_speed();
+
+  record.time_ms = hal::millis();
+  record.speed = speed;
+  if (notch > 0) {
+    const NotchTable_t *table = notch_tables.acquire();
+    record.target = table->power[notch - 1].max_speed;
+    notch_tables.release(table);
+  }
+  record.allowed = train_protection.allowed_speed();
+  record.handle_notch = handle_notch;
+  record.notch = notch;
+  record.resistance = decelSize;
+  record.current_ma = last_current_ma;
+  record.i2c_us = i2c_max_us.exchange(0);
+  record.jitter_us = jitter_us > INT16_MAX ? INT16_MAX : (jitter_us < INT16_MIN ? INT16_MIN : jitter_us);
+
+  if (train_controller.is_feeder_cut()) record.flags |= TELEMETRY_FLAG_FEEDER_CUT;
+  if (train_protection.is_enabled()) record.flags |= TELEMETRY_FLAG_ATP_ENABLED;
+  if (notch != tasc_notch) record.flags |= TELEMETRY_FLAG_ATP_ACTIVE;
+  if (tasc_notch != handle_notch) record.flags |= TELEMETRY_FLAG_TASC_APPLY;
+  if (is_emergency_latched) record.flags |= TELEMETRY_FLAG_EMERGENCY;
+
+  telemetry.push(record);
+}
+
+static void onTickUpdateSpeed(void *param)
+{
+  static uint32_t wake_latency_max_ms = 0;
+  static uint32_t last_tick_us = 0;
+
+  // 前のティックからのずれ (起動・待機明けの最初のティックは0)
+  uint32_t tick_us = hal::micros();
+  int32_t jitter_us = last_tick_us == 0 || is_wake_pending ? 0 : (int32_t)(tick_us - last_tick_us - TICK_PERIOD_UPDATE_SPEED_MS * 1000);
+  last_tick_us = tick_us;
+
+  // 入力を受けてから待機明けの最初のティックまでを起床の遅延とする
+  if (is_wake_pending) {
+    is_wake_pending = false;
+    uint32_t latency_ms = hal::millis() - wake_edge_ms;
+    if (latency_ms > wake_latency_max_ms) wake_latency_max_ms = latency_ms;
+    hal::log("idle: wake after %u ms, latency %u ms (max %u ms)\n",
+             idle_monitor.last_idle_ms(), latency_ms, wake_latency_max_ms);
+  }
+
+  // 保安装置の介入は定位置停止の指示より優先する
+  int8_t handle_notch = is_emergency_latched ? NOTCH_EMERGENCY : notchFromHandle(handle_state);
+  int8_t tasc_notch = target_stop.apply(handle_notch);
+  int8_t notch = train_protection.apply(tasc_notch);
+  if (!speed_control.tick(notch, decelSize)) return;
+
+  applySpeed(speed_control.current_speed_q8(), notch);
+
+  // 遮断中は車両が止まっているので位置を進めない
+  int8_t moving_speed = train_controller.is_feeder_cut() ? 0 : speed_control.current_speed();
+  updateTargetStop(moving_speed);
+  updateProtection(moving_speed);
+
+  if (hal::telemetryPort().is_enabled()) pushTelemetry(handle_notch, tasc_notch, notch, jitter_us);
+
+  // モータードライバが応答してから最初のティックまでを起動時間とする
+  if (!boot_profiler.is_done(BOOT_STAGE_FIRST_TICK) && train_controller.is_available()) {
+    boot_profiler.end(BOOT_STAGE_FIRST_TICK);
+    boot_profiler.report();
+  }
+}
+
+static void onTickSampleCurrent(void *param)
+{
+  static uint32_t over_since_us = 0;
+  static bool is_over = false;
+  static uint32_t cut_max_us = 0;
+  uint16_t current_ma;
+
+  if (!train_controller.is_available() || train_controller.is_switching()) return;
+  uint32_t read_start_us = hal::micros();
+  if (!hal::motorPort().readCurrent(&current_ma)) return;
+  uint32_t sampled_us = hal::micros();
+  recordI2cTime(read_start_us);
+  last_current_ma = current_ma;
+
+  // 閾値を超え続けた時間 (検出時間の待ち) と、遮断を決めたサンプルから遮断し終わるまでの遅延は分けて出す
+  bool is_over_now = current_ma >= OVERCURRENT_CONFIG.threshold_ma;
+  if (is_over_now && !is_over) over_since_us = sampled_us;
+  is_over = is_over_now;
+
+  switch (overcurrent_guard.update(hal::millis(), current_ma)) {
+    case OvercurrentGuard::ACTION_CUT: {
+      train_controller.cutFeeder();
+      uint32_t cut_us = hal::micros() - sampled_us;
+      if (cut_us > cut_max_us) cut_max_us = cut_us;
+      hal::log("overcurrent: %u mA for %u us, cut %u us after the deciding sample (max %u us), retry in %u ms\n",
+               current_ma, sampled_us - over_since_us, cut_us, cut_max_us, overcurrent_guard.backoff_ms());
+      break;
+    }
+    case OvercurrentGuard::ACTION_RESTORE:
+      train_controller.restoreFeeder();
+      hal::log("overcurrent: retry (trip %u)\n", overcurrent_guard.trip_count());
+      break;
+    default:
+      break;
+  }
+}
+
+static void onTickOutput(void *param)
+{
+  uint32_t start_us = hal::micros();
+  train_controller.service();
+  recordI2cTime(start_us);
+}
+
+// 制御ティックが積んだ記録を、UARTの空きの分だけ送る
+static void onTickTelemetry(void *param)
+{
+  telemetry.drain();
+}
+
+// 停車していて、ブレーキ位置で、遮断・再通電の途中でもなく、ボタンも離されている
+static bool isQuiet()
+{
+  int8_t notch = notchFromHandle(handle_state);
+  return speed_control.current_speed() == 0 && notch < 0 && notch != NOTCH_INVALID &&
+         !train_controller.is_feeder_cut() && overcurrent_guard.state() == OvercurrentGuard::STATE_NORMAL &&
+         input_engine.pressed() == 0;
+}
+
+static void enterIdle()
+{
+  int32_t current_ma;
+
+  speed_task.stop();
+  current_task.stop();
+  output_task.stop();
+  telemetry_task.stop();
+
+  bool is_current = hal::readBatteryCurrent(&current_ma);
+  hal::setPowerSave(true);
+  if (is_current) hal::log("idle: enter (active %d mA)\n", current_ma);
+  else hal::log("idle: enter\n");
+}
+
+static void reportIdleCurrent(uint32_t now_ms)
+{
+  static uint32_t reported_since_ms = 0;
+  int32_t current_ma;
+
+  if (now_ms - idle_monitor.idle_since_ms() < IDLE_CURRENT_SETTLE_MS) return;
+  if (reported_since_ms == idle_monitor.idle_since_ms()) return;
+  reported_since_ms = idle_monitor.idle_since_ms();
+
+  if (hal::readBatteryCurrent(&current_ma)) hal::log("idle: current %d mA\n", current_ma);
+}
+
+static void updateIdle(uint32_t now_ms)
+{
+  if (idle_monitor.is_idle()) {
+    reportIdleCurrent(now_ms);
+    return;
+  }
+
+  if (idle_monitor.update(now_ms, isQuiet()) == IdleMonitor::ACTION_ENTER) enterIdle();
+}
+
+// 入力を受けたら周期を待たずに最初のティックを回す
+// 最初のティックが新しい入力を見るように、状態を変える購読者より後に並べる
+template <typename E>
+static void wakeOn(const E &event)
+{
+  uint32_t now_ms = hal::millis();
+  if (!idle_monitor.wake(now_ms)) return;
+
+  hal::setPowerSave(false);
+  wake_edge_ms = now_ms;
+  is_wake_pending = true;
+  output_task.start();
+  current_task.start();
+  if (hal::telemetryPort().is_enabled()) telemetry_task.start();
+  speed_task.start();
+  speed_task.trigger();
+}
+
+// 状態を変える購読者の後に並べて、変わった後の状態を保存・表示する
+template <typename E>
+static void saveSnapshotOn(const E &event)
+{
+  saveSnapshot();
+}
+
+template <typename E>
+static void drawStateOn(const E &event)
+{
+  display.drawRail(is_left, is_evacute, true);
+  display.drawDamp(decelSize);
+}
+
+// 入力イベントの購読者 (並べた順に呼ばれる)
+namespace event {
+
+template <>
+void publish<HandleChangedEvent_t>(const HandleChangedEvent_t &event)
+{
+  SubscriberList<HandleChangedEvent_t, onChangedHandle, wakeOn<HandleChangedEvent_t> >::dispatch(event);
+}
+
+template <>
+void publish<HatChangedEvent_t>(const HatChangedEvent_t &event)
+{
+  SubscriberList<HatChangedEvent_t, onChangedHat, saveSnapshotOn<HatChangedEvent_t>, drawStateOn<HatChangedEvent_t>, wakeOn<HatChangedEvent_t> >::dispatch(event);
+}
+
+template <>
+void publish<ButtonEdgeEvent_t>(const ButtonEdgeEvent_t &event)
+{
+  SubscriberList<ButtonEdgeEvent_t, onButtonEdge, wakeOn<ButtonEdgeEvent_t> >::dispatch(event);
+}
+
+template <>
+void publish<InputActionEvent_t>(const InputActionEvent_t &event)
+{
+  SubscriberList<InputActionEvent_t, onInputAction, logInputAction,
+                 saveSnapshotOn<InputActionEvent_t>, drawStateOn<InputActionEvent_t> >::dispatch(event);
+}
+
+// MIDI機器は今のところ待機から起こすだけ
+template <>
+void publish<MidiPadEvent_t>(const MidiPadEvent_t &event)
+{
+  SubscriberList<MidiPadEvent_t, wakeOn<MidiPadEvent_t> >::dispatch(event);
+}
+
+template <>
+void publish<MidiKeyEvent_t>(const MidiKeyEvent_t &event)
+{
+  SubscriberList<MidiKeyEvent_t, wakeOn<MidiKeyEvent_t> >::dispatch(event);
+}
+
+template <>
+void publish<MidiControlEvent_t>(const MidiControlEvent_t &event)
+{
+  SubscriberList<MidiControlEvent_t, wakeOn<MidiControlEvent_t> >::dispatch(event);
+}
+
+}
+
+static void onHidReport(uint8_t len, const uint8_t *buf)
+{
+  masscon.Parse(len, buf, hal::millis());
+}
+
+static bool initMasconn()
+{
+  return hal::hidSource().begin(onHidReport);
+}
+
+static void taskMotorProbeProc(void *param)
+{
+  // 見つかるまで再試行し続け、起動はタイムアウトで先に進める
+  // ウォームブート時はポイントが保存状態のままなので再駆動しない
+  boot_profiler.begin(BOOT_STAGE_MOTOR, "motor driver");
+  while (!train_controller.begin(MOTOR_PROBE_TIMEOUT_MS, !is_warm_boot)) {
+    hal::delayMs(MOTOR_RETRY_INTERVAL_MS);
+  }
+  boot_profiler.end(BOOT_STAGE_MOTOR);
+
+  motor_ready.post();
+}
+
+void appSetup()
+{
+  SpeedLimitIndex::mirror(POSITION_ZONES, sizeof(POSITION_ZONES) / sizeof(POSITION_ZONES[0]), SPEED_LIMIT_LAP_LENGTH, reversed_position_zones);
+
+  // 最高速度は固定 (保安装置の許容速度の上限にもする)
+  train_protection.setMaxSpeed(SPEED_LIMIT);
+
+  rtc_snapshot = (StateSnapshot_t *)hal::retainedMemory(sizeof(StateSnapshot_t));
+  is_warm_boot = restoreSnapshot();
+  saveSnapshot();
+
+  // モーターモジュール(I2C)の確認は画面・USB(SPI)の初期化と並行して行う
+  boot_profiler.begin(BOOT_STAGE_FIRST_TICK, "first tick");
+  hal::startTask("motor probe task", taskMotorProbeProc, NULL, 2);
+
+  boot_profiler.begin(BOOT_STAGE_DISPLAY, "display");
+  display.begin(SPEED_LIMIT, &notch_tables, &loco_profiles);
+  display.drawRail(is_left, is_evacute, true);
+  display.drawDamp(decelSize);
+  boot_profiler.end(BOOT_STAGE_DISPLAY);
+
+  boot_profiler.begin(BOOT_STAGE_USB, "usb");
+  bool is_usb_ok = initMasconn();
+  if (midi_receiver.init() != 0) is_usb_ok = false;
+  boot_profiler.end(BOOT_STAGE_USB, is_usb_ok);
+
+  // モーターが応答した時点、またはタイムアウトで制御を開始する
+  uint32_t elapsed_ms = hal::millis();
+  uint32_t wait_ms = elapsed_ms < MOTOR_BOOT_TIMEOUT_MS ? MOTOR_BOOT_TIMEOUT_MS - elapsed_ms : 0;
+  bool is_motor_ready = motor_ready.wait(wait_ms);
+  speed_task.start();
+  current_task.start();
+  output_task.start();
+  if (hal::telemetryPort().is_enabled()) telemetry_task.start();
+
+  if (!is_motor_ready) {
+    hal::log("motor driver not found, running without it\n");
+    boot_profiler.report();
+  }
+}
+
+void appLoop()
+{
+  static uint32_t last_ui_ms = 0;
+
+  hal::hidSource().poll();
+  midi_receiver.loop();
+  input_engine.poll(hal::millis());
+
+  // タッチの押下・長押しを取りこぼさないよう、待機中も同じ間隔で確認する
+  if (hal::millis() - last_ui_ms >= UI_POLL_INTERVAL_MS) {
+    last_ui_ms = hal::millis();
+    display.poll();
+    updateIdle(last_ui_ms);
+  }
+
+  // 待機中はループを回し続けずに待つ (この間にCPUが休める)
+  if (idle_monitor.is_idle()) hal::delayMs(IDLE_LOOP_DELAY_MS);
+}
+
+bool appIsIdle()
+{
+  return idle_monitor.is_idle();
+}
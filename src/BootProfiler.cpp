@@ -0,0 +1,49 @@
+#include "BootProfiler.h"
+#include "hal/Hal.h"
+
+BootProfiler::BootProfiler() {
+    for (uint8_t i = 0; i < BOOT_PROFILER_STAGE_MAX; i++) {
+        stages_[i].name = NULL;
+        stages_[i].start_us = 0;
+        stages_[i].end_us = 0;
+        stages_[i].is_done = false;
+        stages_[i].is_ok = false;
+    }
+}
+
+void BootProfiler::begin(uint8_t stage, const char *name) {
+    if (stage >= BOOT_PROFILER_STAGE_MAX) return;
+
+    // 段階ごとに書き込むタスクが決まっているので排他はしない
+    stages_[stage].name = name;
+    stages_[stage].start_us = hal::micros();
+    stages_[stage].is_done = false;
+}
+
+void BootProfiler::end(uint8_t stage, bool is_ok) {
+    if (stage >= BOOT_PROFILER_STAGE_MAX) return;
+
+    stages_[stage].is_ok = is_ok;
+    stages_[stage].end_us = hal::micros();
+    stages_[stage].is_done = true;
+}
+
+bool BootProfiler::is_done(uint8_t stage) {
+    if (stage >= BOOT_PROFILER_STAGE_MAX) return false;
+    return stages_[stage].is_done;
+}
+
+void BootProfiler::report() {
+    hal::log("boot: stage            start(ms)  time(ms)  result\n");
+    for (uint8_t i = 0; i < BOOT_PROFILER_STAGE_MAX; i++) {
+        const Stage_t &stage = stages_[i];
+        if (stage.name == NULL) continue;
+
+        if (!stage.is_done) {
+            hal::log("boot: %-16s %9.1f  %8s  pending\n", stage.name, stage.start_us / 1000.0f, "-");
+        } else {
+            hal::log("boot: %-16s %9.1f  %8.1f  %s\n", stage.name, stage.start_us / 1000.0f,
+                     (stage.end_us - stage.start_us) / 1000.0f, stage.is_ok ? "ok" : "failed");
+        }
+    }
+}
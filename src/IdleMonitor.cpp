@@ -0,0 +1,56 @@
+#include "IdleMonitor.h"
+
+const uint32_t IdleMonitor::NOT_QUIET = UINT32_MAX;
+
+IdleMonitor::IdleMonitor(uint32_t enter_ms):
+    enter_ms_(enter_ms),
+    quiet_since_ms_(NOT_QUIET),
+    idle_since_ms_(0),
+    last_idle_ms_(0),
+    wake_count_(0),
+    is_idle_(false) {
+
+}
+
+IdleMonitor::Action_t IdleMonitor::update(uint32_t now_ms, bool is_quiet) {
+    if (is_idle_) return ACTION_NONE;
+
+    if (!is_quiet) {
+        quiet_since_ms_ = NOT_QUIET;
+        return ACTION_NONE;
+    }
+
+    if (quiet_since_ms_ == NOT_QUIET) quiet_since_ms_ = now_ms;
+    if (now_ms - quiet_since_ms_ < enter_ms_) return ACTION_NONE;
+
+    is_idle_ = true;
+    idle_since_ms_ = now_ms;
+    return ACTION_ENTER;
+}
+
+// 待機中だった場合だけ true を返す (起床の処理は呼び出し側で行う)
+bool IdleMonitor::wake(uint32_t now_ms) {
+    quiet_since_ms_ = NOT_QUIET;
+    if (!is_idle_) return false;
+
+    is_idle_ = false;
+    last_idle_ms_ = now_ms - idle_since_ms_;
+    wake_count_++;
+    return true;
+}
+
+bool IdleMonitor::is_idle() {
+    return is_idle_;
+}
+
+uint32_t IdleMonitor::idle_since_ms() {
+    return idle_since_ms_;
+}
+
+uint32_t IdleMonitor::last_idle_ms() {
+    return last_idle_ms_;
+}
+
+uint32_t IdleMonitor::wake_count() {
+    return wake_count_;
+}
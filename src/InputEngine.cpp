@@ -0,0 +1,136 @@
+#include <string.h>
+#include "InputEngine.h"
+
+InputEngine::InputEngine(const InputBinding_t *bindings, uint8_t num, const Config_t &config):
+    config_(config),
+    chord_num_(0),
+    pressed_(0),
+    timed_(0) {
+    memset(buttons_, 0, sizeof(buttons_));
+    for (uint8_t i = 0; i < INPUT_BUTTON_NUM; i++) {
+        buttons_[i].press_action = INPUT_ACTION_NONE;
+        buttons_[i].hold_action = INPUT_ACTION_NONE;
+    }
+
+    // 割り当ては起動時にボタン毎の表へ展開しておく
+    for (uint8_t i = 0; i < num; i++) {
+        const InputBinding_t &binding = bindings[i];
+
+        if (binding.gesture == INPUT_CHORD) {
+            if (chord_num_ >= INPUT_CHORD_MAX) continue;
+            chords_[chord_num_++] = Chord_t{binding.mask, binding.action, false};
+            continue;
+        }
+
+        for (uint8_t id = 0; id < INPUT_BUTTON_NUM; id++) {
+            if ((binding.mask & (1 << id)) == 0) continue;
+
+            ButtonState_t &button = buttons_[id];
+            if (binding.gesture == INPUT_LONG_PRESS) {
+                button.hold_action = binding.action;
+            } else {
+                button.press_action = binding.action;
+                button.is_repeat = binding.gesture == INPUT_REPEAT;
+            }
+            break;
+        }
+    }
+}
+
+uint16_t InputEngine::pressed() {
+    return pressed_;
+}
+
+void InputEngine::edge(uint8_t id, bool is_down, uint32_t time_ms) {
+    if (id >= INPUT_BUTTON_NUM) return;
+
+    ButtonState_t &button = buttons_[id];
+    button.is_raw_down = is_down;
+
+    // 収束待ちの間は最後の状態だけ覚えておき、poll()で確定させる
+    if (button.is_settling && time_ms - button.edge_ms < config_.debounce_ms) return;
+    accept(id, is_down, time_ms);
+}
+
+void InputEngine::accept(uint8_t id, bool is_down, uint32_t time_ms) {
+    ButtonState_t &button = buttons_[id];
+    uint16_t bit = 1 << id;
+
+    button.is_settling = false;
+    if (is_down == ((pressed_ & bit) != 0)) return;
+
+    button.edge_ms = time_ms;
+    button.is_settling = config_.debounce_ms > 0;
+    button.is_timer_armed = false;
+
+    if (is_down) {
+        pressed_ |= bit;
+        if (button.press_action != INPUT_ACTION_NONE) fire(button.press_action, time_ms);
+
+        if (button.press_action != INPUT_ACTION_NONE && button.is_repeat) {
+            button.next_ms = time_ms + config_.repeat_delay_ms;
+            button.is_timer_armed = true;
+        } else if (button.hold_action != INPUT_ACTION_NONE) {
+            button.next_ms = time_ms + config_.hold_ms;
+            button.is_timer_armed = true;
+        }
+        checkChords(time_ms);
+    } else {
+        pressed_ &= ~bit;
+        for (uint8_t i = 0; i < chord_num_; i++) {
+            if (chords_[i].mask & bit) chords_[i].is_fired = false;
+        }
+    }
+
+    if (button.is_settling || button.is_timer_armed) timed_ |= bit;
+}
+
+void InputEngine::checkChords(uint32_t time_ms) {
+    for (uint8_t i = 0; i < chord_num_; i++) {
+        Chord_t &chord = chords_[i];
+        if (chord.is_fired || (pressed_ & chord.mask) != chord.mask) continue;
+
+        // ばらばらに押して揃ったものは和音とみなさない
+        bool is_within = true;
+        for (uint8_t id = 0; id < INPUT_BUTTON_NUM && is_within; id++) {
+            if ((chord.mask & (1 << id)) == 0) continue;
+            is_within = time_ms - buttons_[id].edge_ms <= config_.chord_window_ms;
+        }
+        if (!is_within) continue;
+
+        chord.is_fired = true;
+        fire(chord.action, time_ms);
+    }
+}
+
+void InputEngine::poll(uint32_t now_ms) {
+    uint16_t timed = timed_;
+
+    for (uint8_t id = 0; timed != 0; id++, timed >>= 1) {
+        if ((timed & 1) == 0) continue;
+
+        ButtonState_t &button = buttons_[id];
+        uint16_t bit = 1 << id;
+
+        if (button.is_settling && now_ms - button.edge_ms >= config_.debounce_ms) {
+            button.is_settling = false;
+            if (button.is_raw_down != ((pressed_ & bit) != 0)) accept(id, button.is_raw_down, now_ms);
+        }
+
+        if (button.is_timer_armed && (int32_t)(now_ms - button.next_ms) >= 0) {
+            if (button.is_repeat) {
+                fire(button.press_action, now_ms);
+                button.next_ms += config_.repeat_ms;
+            } else {
+                fire(button.hold_action, now_ms);
+                button.is_timer_armed = false;
+            }
+        }
+
+        if (!button.is_settling && !button.is_timer_armed) timed_ &= ~bit;
+    }
+}
+
+void InputEngine::fire(uint8_t action, uint32_t time_ms) {
+    event::publish(InputActionEvent_t{action, time_ms});
+}
@@ -1,14 +1,13 @@
 #include "MasterController.h"
 
 MasterController::MasterController(MasterControllerEvents *evt) : joyEvents_(evt),
-                                                                  oldHat_(0xDE),
-                                                                  oldButtons_(0)
+                                                                  oldHat_(0xDE)
 {
     for (uint8_t i = 0; i < RPT_GEMEPAD_LEN; i++)
         oldPad_[i] = 0xD;
 }
 
-void MasterController::Parse(USBHID *hid, bool is_rpt_id, uint8_t len, uint8_t *buf)
+void MasterController::Parse(uint8_t len, const uint8_t *buf, uint32_t time_ms)
 {
     bool match = true;
 
@@ -23,7 +22,7 @@ void MasterController::Parse(USBHID *hid, bool is_rpt_id, uint8_t len, uint8_t *
     // Calling Game Pad event handler
     if (!match && joyEvents_)
     {
-        joyEvents_->OnGamePadChanged((const GamePadEventData *)buf);
+        joyEvents_->OnGamePadChanged((const GamePadEventData *)buf, time_ms);
         for (uint8_t i = 0; i < RPT_GEMEPAD_LEN; i++)
             oldPad_[i] = buf[i];
     }
@@ -37,94 +36,43 @@ void MasterController::Parse(USBHID *hid, bool is_rpt_id, uint8_t len, uint8_t *
         oldHat_ = hat;
     }
 
-    uint16_t buttons = (0x0000 | buf[6]);
-    buttons <<= 4;
-    buttons |= (buf[5] >> 4);
-    uint16_t changes = (buttons ^ oldButtons_);
-
-    // Calling Button Event Handler for every button changed
-    if (changes)
-    {
-        for (uint8_t i = 0; i < 0x0C; i++)
-        {
-            uint16_t mask = (0x0001 << i);
-            if (((mask & changes) > 0) && joyEvents_)
-            {
-                if ((buttons & mask) > 0)
-                    joyEvents_->OnButtonDn(i + 1);
-                else
-                    joyEvents_->OnButtonUp(i + 1);
-            }
-        }
-        oldButtons_ = buttons;
-    }
+    // このマスコンのボタンは X/Y にあるので、ボタン毎のエッジは OnGamePadChanged() で出す
 }
 
 MasterControllerEvents::MasterControllerEvents() : before_handle_(0),
                                                    before_hat_(0),
-                                                   before_button_(0),
-                                                   before_additional_button_(0),
-                                                   onChangedHandle_(NULL),
-                                                   onChangedHat_(NULL),
-                                                   onChangedButton_(NULL),
-                                                   onChangedAdditionalButton_(NULL)
-{
-}
-
-void MasterControllerEvents::setOnChangedHandle(HandleEvent_t onChangedHandle)
-{
-    onChangedHandle_ = onChangedHandle;
-}
-
-void MasterControllerEvents::setOnChangedHat(HatEvent_t onChangedHat)
+                                                   before_buttons_(0)
 {
-    onChangedHat_ = onChangedHat;
 }
 
-void MasterControllerEvents::setOnChangedButton(ButtonEvent_t onChangedButton)
-{
-    onChangedButton_ = onChangedButton;
-}
-
-void MasterControllerEvents::setOnChangedAdditionalButton(AdditionalButtonEvent_t onChangedAdditionalButton)
-{
-    onChangedAdditionalButton_ = onChangedAdditionalButton;
-}
-
-void MasterControllerEvents::OnGamePadChanged(const GamePadEventData *evt)
+void MasterControllerEvents::OnGamePadChanged(const GamePadEventData *evt, uint32_t time_ms)
 {
     uint8_t handle = evt->Rz;
     uint8_t hat = (evt->Z1 & MASK_HAT);
-    uint8_t button = evt->X;
-    uint8_t additional_button = evt->Y;
+    uint16_t buttons = evt->X | ADDITIONAL_BUTTON_BIT(evt->Y);
+    uint16_t changes = buttons ^ before_buttons_;
 
     // Serial.printf("x:%02x / y:%02x / z1:%02x / z2:%02x / Rz:%02x\n", evt->X, evt->Y, evt->Z1, evt->Z2, evt->Rz);
 
     if (hat != before_hat_) {
-        if (onChangedHat_) {
-            onChangedHat_((HatState_t)hat);
-        }
+        event::publish(HatChangedEvent_t{(HatState_t)hat});
         before_hat_ = hat;
     }
 
-    if (additional_button != before_additional_button_) {
-        if (onChangedAdditionalButton_) {
-            onChangedAdditionalButton_((AdditionalButton_t)additional_button);
-        }
-        before_additional_button_ = additional_button;
-    }
+    // 変化したボタン毎にエッジを出す (変化したビットだけを順に見る)
+    before_buttons_ = buttons;
+    while (changes) {
+        uint8_t i = __builtin_ctz(changes);
+        changes &= changes - 1;
 
-    if (button != before_button_) {
-        if (onChangedButton_) {
-            onChangedButton_((Button_t)button);
-        }
-        before_button_ = button;
+        if (buttons & (0x0001 << i))
+            OnButtonDn(i, time_ms);
+        else
+            OnButtonUp(i, time_ms);
     }
 
     if (handle != before_handle_) {
-        if (onChangedHandle_) {
-            onChangedHandle_((HandleState_t)handle);
-        }
+        event::publish(HandleChangedEvent_t{(HandleState_t)handle});
         before_handle_ = handle;
     }
 }
@@ -133,10 +81,12 @@ void MasterControllerEvents::OnHatSwitch(uint8_t hat)
 {
 }
 
-void MasterControllerEvents::OnButtonUp(uint8_t but_id)
+void MasterControllerEvents::OnButtonUp(uint8_t but_id, uint32_t time_ms)
 {
+    event::publish(ButtonEdgeEvent_t{but_id, false, time_ms});
 }
 
-void MasterControllerEvents::OnButtonDn(uint8_t but_id)
+void MasterControllerEvents::OnButtonDn(uint8_t but_id, uint32_t time_ms)
 {
+    event::publish(ButtonEdgeEvent_t{but_id, true, time_ms});
 }
\ No newline at end of file
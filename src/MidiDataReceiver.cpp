@@ -1,6 +1,7 @@
-#include <usbh_midi.h>
+#include <stddef.h>
 #include "MidiDataReceiver.h"
 
+#define MIDI_EVENT_PACKET_SIZE      64
 #define MIDI_PACKET_SIZE            4
 #define IDX_MIDI_CN_CIN             0
 #define IDX_MIDI_CMD_CHANNEL        1
@@ -40,16 +41,6 @@ static inline bool isBlackKeyNote(uint8_t note) {
     }
 }
 
-static bool is_connected = false;
-
-static void onInit() {
-    is_connected = true;
-}
-
-static void onRelease() {
-    is_connected = false;
-}
-
 const uint8_t MidiDataReceiver::kPadChannel = 8;
 const uint8_t MidiDataReceiver::kControlChannel = 1;
 
@@ -67,73 +58,26 @@ const uint8_t MidiDataReceiver::kControlNumDecel = 0x16;
 const uint8_t MidiDataReceiver::kControlNumMaxSpeed = 0x17;
 
 
-MidiDataReceiver::MidiDataReceiver(): usb_(), midi_(&usb_) {
-    onEmergencyStop = NULL;
-    onSwitchDirection = NULL;
-    onSwitchPoint = NULL;
-    onAccel = NULL;
-    onBrake = NULL;
-    onChangeAccelSize = NULL;
-    onChangeBrakeSize = NULL;
-    onChangeDecelSize = NULL;
+MidiDataReceiver::MidiDataReceiver(hal::MidiSource *source): source_(source) {
+
 }
 
 int8_t MidiDataReceiver::init() {
-    if (usb_.Init() == -1) return -1;
-
-    is_connected = false;
-    midi_.attachOnInit(onInit);
+    if (!source_->begin()) return -1;
 
     return 0;
 }
 
-void MidiDataReceiver::setOnEmergencyStop(NoteOnEvent_t event) {
-    onEmergencyStop = event;
-}
-
-void MidiDataReceiver::setOnSwitchDirection(NoteOnEvent_t event) {
-    onSwitchDirection = event;
-}
-
-void MidiDataReceiver::setOnSwitchPoint(NoteOnEvent_t event) {
-    onSwitchPoint = event;
-}
-
-void MidiDataReceiver::setOnAccel(NoteOnEvent_t event) {
-    onAccel = event;
-}
-
-void MidiDataReceiver::setOnBrake(NoteOnEvent_t event) {
-    onBrake = event;
-}
-
-void MidiDataReceiver::setOnChangeAccelSize(ControlChangeEvent_t event) {
-    onChangeAccelSize = event;
-}
-
-void MidiDataReceiver::setOnChangeBrakeSize(ControlChangeEvent_t event) {
-    onChangeBrakeSize = event;
-}
-
-void MidiDataReceiver::setOnChangeDecelSize(ControlChangeEvent_t event) {
-    onChangeDecelSize = event;
-}
-
-void MidiDataReceiver::setOnChangeMaxSpeed(ControlChangeEvent_t event) {
-    onChangeMaxSpeed = event;
-}
-
 void MidiDataReceiver::loop() {
-    usb_.Task();
-
-    if (!is_connected) {
+    // USBホストのタスク処理はHidSource::poll()で行う
+    if (!source_->is_connected()) {
         return;
     }
 
     uint8_t buffer[MIDI_EVENT_PACKET_SIZE];
     uint16_t recved_size = 0;
 
-    if (midi_.RecvData(&recved_size, buffer) != 0) return;
+    if (!source_->read(buffer, &recved_size)) return;
 
     for (uint16_t i = 0; i < recved_size; i += MIDI_PACKET_SIZE) {
         uint8_t cin = getCin(buffer[i + IDX_MIDI_CN_CIN]);
@@ -145,19 +89,13 @@ void MidiDataReceiver::loop() {
 
             switch (note) {
                 case kPadNoteEmergencyStop:
-                    if (onEmergencyStop != NULL) {
-                        onEmergencyStop(true);
-                    }
+                    event::publish(MidiPadEvent_t{MidiPadEmergencyStop});
                     break;
                 case kPadNoteSwitchDirection:
-                    if (onSwitchDirection != NULL) {
-                        onSwitchDirection(true);
-                    }
+                    event::publish(MidiPadEvent_t{MidiPadSwitchDirection});
                     break;
                 case kPadNoteSwitchPoint:
-                    if (onSwitchPoint != NULL) {
-                        onSwitchPoint(true);
-                    }
+                    event::publish(MidiPadEvent_t{MidiPadSwitchPoint});
                     break;
             }
         } else if (channel == kControlChannel) {
@@ -169,38 +107,23 @@ void MidiDataReceiver::loop() {
 
                 switch (num) {
                     case kControlNumAccel:
-                        if (onChangeAccelSize != NULL) {
-                            onChangeAccelSize(value);
-                        }
+                        event::publish(MidiControlEvent_t{MidiControlAccelSize, value});
                         break;
                     case kControlNumBrake:
-                        if (onChangeBrakeSize != NULL) {
-                            onChangeBrakeSize(value);
-                        }
+                        event::publish(MidiControlEvent_t{MidiControlBrakeSize, value});
                         break;
                     case kControlNumDecel:
-                        if (onChangeDecelSize != NULL) {
-                            onChangeDecelSize(value);
-                        }
+                        event::publish(MidiControlEvent_t{MidiControlDecelSize, value});
                         break;
                     case kControlNumMaxSpeed:
-                        if (onChangeMaxSpeed != NULL) {
-                            onChangeMaxSpeed(value);
-                        }
+                        event::publish(MidiControlEvent_t{MidiControlMaxSpeed, value});
+                        break;
                     default:
                         break;
                 }
             } else if (cin == kSpeedAccelBrakeOnCin || cin == kSpeedAccelBrakeOffCin) {
                 uint8_t note = buffer[i + IDX_NOTE];
-                if (isBlackKeyNote(note)) {
-                    if (onAccel != NULL) {
-                        onAccel(cin == kSpeedAccelBrakeOnCin);
-                    }
-                } else {
-                    if (onBrake != NULL) {
-                        onBrake(cin == kSpeedAccelBrakeOnCin);
-                    }
-                }
+                event::publish(MidiKeyEvent_t{isBlackKeyNote(note), cin == kSpeedAccelBrakeOnCin});
             }
         }
     }
@@ -0,0 +1,229 @@
+#include "NotchEditor.h"
+#include "display.h"
+
+#include <string.h>
+
+// ページ: 力行1-5, ブレーキ1-8 + 非常, 環境抵抗レベル1-10, 使用車両, 車両1-4
+#define PAGE_POWER_TOP              0
+#define PAGE_BRAKE_TOP              (PAGE_POWER_TOP + POWER_NOTCH_NUM)
+#define PAGE_RESISTANCE_TOP         (PAGE_BRAKE_TOP + BRAKE_NOTCH_NUM)
+#define PAGE_LOCO_SELECT            (PAGE_RESISTANCE_TOP + ENV_RESISTANCE_NUM - 1)
+#define PAGE_LOCO_TOP               (PAGE_LOCO_SELECT + 1)
+
+const uint8_t NotchEditor::PAGE_NUM = PAGE_LOCO_TOP + LOCO_PROFILE_NUM;
+const int16_t NotchEditor::HEADER_HEIGHT = 50;
+const int16_t NotchEditor::ROW_TOP = 70;
+const int16_t NotchEditor::ROW_HEIGHT = 55;
+const int16_t NotchEditor::FOOTER_HEIGHT = 60;
+const int16_t NotchEditor::BUTTON_WIDTH = 50;
+
+NotchEditor::NotchEditor(Display *display):
+    tables_(NULL),
+    profiles_(NULL),
+    display_(display),
+    edit_(NULL),
+    is_active_(false),
+    is_dirty_(false),
+    page_(0) {
+
+}
+
+void NotchEditor::begin(NotchTableStore *tables, LocoProfiles_t *profiles) {
+    tables_ = tables;
+    profiles_ = profiles;
+}
+
+bool NotchEditor::is_active() {
+    return is_active_;
+}
+
+bool NotchEditor::update() {
+    const m5::touch_detail_t &touch = M5.Touch.getDetail();
+
+    if (tables_ == NULL || profiles_ == NULL) return false;
+
+    if (!is_active_) {
+        // 画面長押しで編集開始
+        if (touch.wasHold()) open();
+        return is_active_;
+    }
+
+    if (touch.wasPressed()) {
+        onTouch(touch.x, touch.y);
+    }
+    return is_active_;
+}
+
+void NotchEditor::open() {
+    is_active_ = true;
+    is_dirty_ = false;
+    edit_ = NULL;
+    loco_edit_ = *profiles_;
+    display_->setSuspended(true);
+    draw();
+}
+
+void NotchEditor::close() {
+    // 未適用の変更は破棄する
+    is_active_ = false;
+    is_dirty_ = false;
+    edit_ = NULL;
+    display_->setSuspended(false);
+}
+
+uint8_t NotchEditor::fields(Field_t *fields) {
+    // 車両の設定は常に複製を編集する
+    if (page_ == PAGE_LOCO_SELECT) {
+        fields[0] = Field_t{"使用車両", &loco_edit_.selected, 1, LOCO_PROFILE_NUM};
+        return 1;
+    }
+
+    if (page_ >= PAGE_LOCO_TOP) {
+        LocoProfile_t &loco = loco_edit_.loco[page_ - PAGE_LOCO_TOP];
+        fields[0] = Field_t{"動き出し", &loco.min_start, 0, 60};
+        fields[1] = Field_t{"キック", &loco.kick_level, 0, 127};
+        fields[2] = Field_t{"キック長", &loco.kick_frames, 0, 20};
+        return 3;
+    }
+
+    // 編集前は現在のテーブルを表示だけする
+    NotchTable_t *table = edit_ != NULL ? edit_ : const_cast<NotchTable_t *>(tables_->active());
+
+    if (page_ < PAGE_BRAKE_TOP) {
+        PowerNotchInfo_t &power = table->power[page_ - PAGE_POWER_TOP];
+        fields[0] = Field_t{"最大速度", &power.max_speed, 1, 127};
+        fields[1] = Field_t{"加速度", &power.base_accel, 1, 50};
+        fields[2] = Field_t{"周期", &power.period, 1, 30};
+        return 3;
+    }
+
+    if (page_ < PAGE_RESISTANCE_TOP) {
+        BrakeNotchInfo_t &brake = table->brake[page_ - PAGE_BRAKE_TOP];
+        fields[0] = Field_t{"周期", &brake.period, 1, 30};
+        fields[1] = Field_t{"減速度", &brake.decel, 1, 127};
+        return 2;
+    }
+
+    EnvironmentResistance_t &resistance = table->resistance[page_ - PAGE_RESISTANCE_TOP + 1];
+    fields[0] = Field_t{"減速量", &resistance.decel, 1, 10};
+    fields[1] = Field_t{"周期", &resistance.period, 1, 60};
+    return 2;
+}
+
+void NotchEditor::pageTitle(char *buff, size_t len) {
+    if (page_ < PAGE_BRAKE_TOP) {
+        snprintf(buff, len, "力行 P%d", page_ - PAGE_POWER_TOP + 1);
+    } else if (page_ == PAGE_RESISTANCE_TOP - 1) {
+        snprintf(buff, len, "非常");
+    } else if (page_ < PAGE_RESISTANCE_TOP) {
+        snprintf(buff, len, "ブレーキ B%d", page_ - PAGE_BRAKE_TOP + 1);
+    } else if (page_ < PAGE_LOCO_SELECT) {
+        snprintf(buff, len, "抵抗 %d", page_ - PAGE_RESISTANCE_TOP + 1);
+    } else if (page_ == PAGE_LOCO_SELECT) {
+        snprintf(buff, len, "使用車両");
+    } else {
+        snprintf(buff, len, "車両 %d", page_ - PAGE_LOCO_TOP + 1);
+    }
+}
+
+void NotchEditor::onTouch(int16_t x, int16_t y) {
+    LovyanGFX *gfx = display_->gfx();
+    int16_t width = gfx->width();
+
+    if (y < HEADER_HEIGHT) {
+        if (x < BUTTON_WIDTH) page_ = (page_ + PAGE_NUM - 1) % PAGE_NUM;
+        else if (x >= width - BUTTON_WIDTH) page_ = (page_ + 1) % PAGE_NUM;
+        else return;
+        draw();
+        return;
+    }
+
+    if (y >= gfx->height() - FOOTER_HEIGHT) {
+        if (x >= width / 2) {
+            close();
+            return;
+        }
+
+        if (is_dirty_) {
+            // 制御ティックは次の周期から新しいテーブルを参照する
+            if (edit_ != NULL) tables_->commit();
+            edit_ = NULL;
+
+            // 各項目は1バイトなので出力タスクはそのまま読んでよい
+            memcpy(profiles_, &loco_edit_, sizeof(LocoProfiles_t));
+            is_dirty_ = false;
+            draw();
+        }
+        return;
+    }
+
+    if (y < ROW_TOP || x < width - BUTTON_WIDTH * 2) return;
+
+    Field_t items[NOTCH_EDITOR_FIELD_MAX];
+    uint8_t row = (y - ROW_TOP) / ROW_HEIGHT;
+    if (row >= fields(items)) return;
+
+    // 最初の変更で裏面に現在のテーブルを複製する
+    // 適用の直後で前の面をまだティックが読んでいる間は、このタッチを捨てる
+    if (edit_ == NULL && page_ < PAGE_LOCO_SELECT) {
+        edit_ = tables_->beginEdit();
+        if (edit_ == NULL) return;
+        fields(items);
+    }
+
+    Field_t &field = items[row];
+    if (x < width - BUTTON_WIDTH) {
+        if (*field.value > field.min) (*field.value)--;
+    } else {
+        if (*field.value < field.max) (*field.value)++;
+    }
+    is_dirty_ = true;
+    draw();
+}
+
+void NotchEditor::draw() {
+    LovyanGFX *gfx = display_->gfx();
+    int16_t width = gfx->width();
+    int16_t height = gfx->height();
+    char buff[24];
+
+    gfx->startWrite();
+    gfx->fillScreen(BLACK);
+    gfx->setFont(&fonts::lgfxJapanGothic_24);
+    gfx->setTextColor(WHITE);
+
+    gfx->setTextDatum(middle_center);
+    pageTitle(buff, sizeof(buff));
+    gfx->drawString(buff, width / 2, HEADER_HEIGHT / 2);
+    gfx->drawString("<", BUTTON_WIDTH / 2, HEADER_HEIGHT / 2);
+    gfx->drawString(">", width - BUTTON_WIDTH / 2, HEADER_HEIGHT / 2);
+    gfx->drawFastHLine(0, HEADER_HEIGHT, width, DARKGREY);
+
+    Field_t items[NOTCH_EDITOR_FIELD_MAX];
+    uint8_t count = fields(items);
+    for (uint8_t i = 0; i < count; i++) {
+        int16_t top = ROW_TOP + ROW_HEIGHT * i;
+        int16_t center_y = top + ROW_HEIGHT / 2;
+
+        gfx->setTextDatum(middle_left);
+        gfx->drawString(items[i].label, 5, center_y);
+
+        gfx->setTextDatum(middle_right);
+        snprintf(buff, sizeof(buff), "%d", *items[i].value);
+        gfx->drawString(buff, width - BUTTON_WIDTH * 2 - 8, center_y);
+
+        gfx->setTextDatum(middle_center);
+        gfx->drawRoundRect(width - BUTTON_WIDTH * 2 + 2, top + 4, BUTTON_WIDTH - 4, ROW_HEIGHT - 8, 6, WHITE);
+        gfx->drawString("-", width - BUTTON_WIDTH * 3 / 2, center_y);
+        gfx->drawRoundRect(width - BUTTON_WIDTH + 2, top + 4, BUTTON_WIDTH - 4, ROW_HEIGHT - 8, 6, WHITE);
+        gfx->drawString("+", width - BUTTON_WIDTH / 2, center_y);
+    }
+
+    int16_t footer_top = height - FOOTER_HEIGHT;
+    gfx->setTextDatum(middle_center);
+    gfx->fillRoundRect(4, footer_top + 4, width / 2 - 8, FOOTER_HEIGHT - 8, 8, is_dirty_ ? DARKGREEN : DARKGREY);
+    gfx->drawString("適用", width / 4, footer_top + FOOTER_HEIGHT / 2);
+    gfx->drawRoundRect(width / 2 + 4, footer_top + 4, width / 2 - 8, FOOTER_HEIGHT - 8, 8, WHITE);
+    gfx->drawString("終了", width * 3 / 4, footer_top + FOOTER_HEIGHT / 2);
+    gfx->endWrite();
+}
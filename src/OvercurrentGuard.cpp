@@ -0,0 +1,84 @@
+#include "OvercurrentGuard.h"
+
+#define NOT_OVER                    UINT32_MAX
+
+OvercurrentGuard::OvercurrentGuard(const Config_t &config):
+    config_(config) {
+    reset();
+}
+
+void OvercurrentGuard::reset() {
+    state_ = STATE_NORMAL;
+    since_ms_ = 0;
+    over_since_ms_ = NOT_OVER;
+    backoff_ms_ = config_.backoff_ms;
+    trip_count_ = 0;
+}
+
+OvercurrentGuard::Action_t OvercurrentGuard::update(uint32_t now_ms, uint16_t current_ma) {
+    bool is_over = current_ma >= config_.threshold_ma;
+
+    switch (state_) {
+        case STATE_NORMAL:
+            if (!is_over) break;
+            state_ = STATE_SUSPECT;
+            since_ms_ = now_ms;
+            // 検出時間0なら最初のサンプルで遮断する
+            if (config_.window_ms > 0) break;
+            // fall through
+
+        case STATE_SUSPECT:
+            if (!is_over) {
+                state_ = STATE_NORMAL;
+                break;
+            }
+            if (now_ms - since_ms_ < config_.window_ms) break;
+            state_ = STATE_TRIPPED;
+            since_ms_ = now_ms;
+            trip_count_++;
+            return ACTION_CUT;
+
+        case STATE_TRIPPED:
+            if (now_ms - since_ms_ < backoff_ms_) break;
+            state_ = STATE_RETRY;
+            since_ms_ = now_ms;
+            over_since_ms_ = NOT_OVER;
+            return ACTION_RESTORE;
+
+        case STATE_RETRY:
+            // 起動電流で誤検出しないよう、再通電中も検出時間は同じにする
+            if (!is_over) {
+                over_since_ms_ = NOT_OVER;
+            } else if (over_since_ms_ == NOT_OVER) {
+                over_since_ms_ = now_ms;
+            }
+
+            if (over_since_ms_ != NOT_OVER && now_ms - over_since_ms_ >= config_.window_ms) {
+                // まだ短絡しているので待ちを延ばして遮断し直す
+                backoff_ms_ *= 2;
+                if (backoff_ms_ > config_.backoff_max_ms) backoff_ms_ = config_.backoff_max_ms;
+                state_ = STATE_TRIPPED;
+                since_ms_ = now_ms;
+                trip_count_++;
+                return ACTION_CUT;
+            }
+            if (over_since_ms_ == NOT_OVER && now_ms - since_ms_ >= config_.stable_ms) {
+                state_ = STATE_NORMAL;
+                backoff_ms_ = config_.backoff_ms;
+            }
+            break;
+    }
+    return ACTION_NONE;
+}
+
+OvercurrentGuard::State_t OvercurrentGuard::state() {
+    return state_;
+}
+
+uint32_t OvercurrentGuard::backoff_ms() {
+    return backoff_ms_;
+}
+
+uint32_t OvercurrentGuard::trip_count() {
+    return trip_count_;
+}
@@ -0,0 +1,145 @@
+#include <string.h>
+#include "SpeedControl.h"
+
+NotchTableStore::NotchTableStore(const NotchTable_t &initial) {
+    buffers_[0] = initial;
+    buffers_[1] = initial;
+    readers_[0].store(0);
+    readers_[1].store(0);
+    active_.store(&buffers_[0]);
+}
+
+uint8_t NotchTableStore::indexOf(const NotchTable_t *table) const {
+    return table == &buffers_[0] ? 0 : 1;
+}
+
+const NotchTable_t *NotchTableStore::active() const {
+    return active_.load(std::memory_order_acquire);
+}
+
+// 参照数を増やした後にまだ表面なら、編集側はこの面を書き換えない
+// (増やす前に切り替わっていたら戻してやり直す)
+const NotchTable_t *NotchTableStore::acquire() const {
+    while (true) {
+        const NotchTable_t *table = active_.load();
+        std::atomic<uint8_t> &readers = readers_[indexOf(table)];
+        readers.fetch_add(1);
+        if (active_.load() == table) return table;
+        readers.fetch_sub(1);
+    }
+}
+
+void NotchTableStore::release(const NotchTable_t *table) const {
+    readers_[indexOf(table)].fetch_sub(1, std::memory_order_release);
+}
+
+NotchTable_t *NotchTableStore::beginEdit() {
+    const NotchTable_t *current = active();
+    uint8_t back = 1 - indexOf(current);
+
+    // 切り替え直後で、前の面をまだティックが読んでいる
+    if (readers_[back].load() != 0) return NULL;
+
+    memcpy(&buffers_[back], current, sizeof(NotchTable_t));
+    return &buffers_[back];
+}
+
+void NotchTableStore::commit() {
+    const NotchTable_t *current = active();
+    active_.store(&buffers_[1 - indexOf(current)]);
+}
+
+SpeedControl::SpeedControl(const NotchTableStore *tables):
+    tables_(tables),
+    speed_(0),
+    tick_count_(0) {
+
+}
+
+// 表示・保安装置・定位置停止は整数の速度で扱う
+int8_t SpeedControl::current_speed() {
+    return speed_ >> SPEED_Q8_SHIFT;
+}
+
+// 出力段へは小数部ごと渡す
+uint16_t SpeedControl::current_speed_q8() {
+    return speed_;
+}
+
+void SpeedControl::reset(int8_t speed) {
+    speed_ = (int32_t)speed << SPEED_Q8_SHIFT;
+    tick_count_ = 0;
+}
+
+// tick()で速度がspeedから0になるまでに進む距離 (速度 x ティック)
+// period ティック毎に decel ずつ減速するので period * Σ(v - j * decel) (j = 1..v/decel) に、
+// 最初の減速までの待ちとして周期の位相の平均 (period - 1) / 2 ティック分を足す
+uint32_t SpeedControl::brakingDistance(const BrakeNotchInfo_t &brake, int8_t speed) {
+    if (speed <= 0) return 0;
+
+    uint32_t v = speed;
+    uint32_t decel = brake.decel > 0 ? brake.decel : 1;
+    uint32_t steps = v / decel;
+    uint32_t sum = steps * v - decel * steps * (steps + 1) / 2;
+    return brake.period * sum + (brake.period - 1) * v / 2;
+}
+
+bool SpeedControl::tick(int8_t notch, uint8_t resistance) {
+    if (notch == NOTCH_INVALID) return false;
+
+    // ティック中は同じテーブルを参照する
+    const NotchTable_t *table = tables_->acquire();
+    step(table, notch, resistance);
+    tables_->release(table);
+    return true;
+}
+
+void SpeedControl::step(const NotchTable_t *table, int8_t notch, uint8_t resistance) {
+    // 非常ブレーキの処理
+    if (notch == NOTCH_EMERGENCY) {
+        BrakeNotchInfo_t current = table->brake[BRAKE_NOTCH_NUM - 1];  // 非常ブレーキは配列の最後
+        speed_ -= (int32_t)current.decel << SPEED_Q8_SHIFT;  // 毎ティック最大減速度で減速
+        if (speed_ < 0) speed_ = 0;
+        return;
+    }
+
+    // 力行制御
+    if (notch > 0) {
+        PowerNotchInfo_t current = table->power[notch - 1];
+        if (tick_count_ % current.period == 0) {  // 周期に応じて加速
+            // 加速度は小数部まで求めて切り捨てない (最低1、目標は越えない)
+            const int32_t one = 1 << SPEED_Q8_SHIFT;
+            int32_t speed_diff = ((int32_t)current.max_speed << SPEED_Q8_SHIFT) - speed_;
+            if (speed_diff > 0) {
+                int32_t accel = (current.base_accel * speed_diff) / current.max_speed;
+                if (accel < one) accel = one;
+                speed_ += accel < speed_diff ? accel : speed_diff;
+            } else if (speed_diff < 0) {
+                int32_t decel = (int32_t)current.base_accel * (-speed_diff) / (speed_ >> SPEED_Q8_SHIFT);
+                if (decel < one) decel = one;
+                speed_ -= decel < -speed_diff ? decel : -speed_diff;
+            }
+        }
+    }
+    // ブレーキ制御
+    else if (notch < 0) {
+        BrakeNotchInfo_t current = table->brake[-notch - 1];
+        if (tick_count_ % current.period == 0) {
+            speed_ -= (int32_t)current.decel << SPEED_Q8_SHIFT;
+        }
+    }
+
+    // 環境抵抗の処理
+    if (resistance > 0 && notch == 0) {
+        EnvironmentResistance_t current = table->resistance[resistance];
+        if (tick_count_ % current.period == 0) {
+            speed_ -= (int32_t)current.decel << SPEED_Q8_SHIFT;
+        }
+    }
+
+    // 速度の下限チェック
+    if (speed_ < 0) speed_ = 0;
+
+    // ティックカウンタの更新
+    tick_count_++;
+}
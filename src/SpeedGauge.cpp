@@ -0,0 +1,51 @@
+#include "SpeedGauge.h"
+
+const float SpeedGauge::START_DEG = 150;
+const float SpeedGauge::RANGE_DEG = 240;
+const float SpeedGauge::END_DEG = START_DEG + RANGE_DEG;
+const int8_t SpeedGauge::SPEED_MIN = 0;
+const int8_t SpeedGauge::SPEED_MAX = 127;
+
+SpeedGauge::SpeedGauge():
+    max_speed_(SPEED_MAX),
+    speed_(0),
+    drawn_speed_(0) {
+
+}
+
+void SpeedGauge::setMaxSpeed(int8_t max_speed) {
+    max_speed_ = max_speed;
+}
+
+void SpeedGauge::setSpeed(int8_t speed) {
+    if (speed < SPEED_MIN) speed = 0;
+    else if (speed > max_speed_) speed = max_speed_;
+    speed_ = speed;
+}
+
+// 前回描いた速度との差分だけを返す
+bool SpeedGauge::nextArc(Arc_t *arc) {
+    if (speed_ == drawn_speed_) return false;
+
+    float deg = START_DEG + RANGE_DEG * speed_ / max_speed_;
+    if (speed_ > drawn_speed_) {
+        arc->start_deg = START_DEG;
+        arc->end_deg = deg;
+        arc->is_fill = true;
+    } else {
+        arc->start_deg = deg;
+        arc->end_deg = END_DEG;
+        arc->is_fill = false;
+    }
+    drawn_speed_ = speed_;
+    return true;
+}
+
+// 画面を消した後は0から描き直す
+void SpeedGauge::invalidate() {
+    drawn_speed_ = 0;
+}
+
+int8_t SpeedGauge::speed() {
+    return speed_;
+}
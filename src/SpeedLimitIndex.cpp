@@ -0,0 +1,81 @@
+#include <stddef.h>
+#include "SpeedLimitIndex.h"
+
+SpeedLimitIndex::SpeedLimitIndex(const SpeedLimitZone_t *zones, uint16_t count, uint32_t period,
+                                 const SpeedLimitZone_t *reversed):
+    forward_(zones),
+    reversed_(period > 0 ? reversed : NULL),
+    zones_(zones),
+    count_(zones != NULL ? count : 0),
+    period_(period),
+    cursor_(0),
+    position_(0) {
+
+}
+
+// 周回の長さから位置を折り返し、区間の並びを逆にする ([start, end) -> [period - end, period - start))
+void SpeedLimitIndex::mirror(const SpeedLimitZone_t *zones, uint16_t count, uint32_t period, SpeedLimitZone_t *reversed) {
+    for (uint16_t i = 0; i < count; i++) {
+        const SpeedLimitZone_t &zone = zones[count - 1 - i];
+        reversed[i] = SpeedLimitZone_t{period - zone.end, period - zone.start, zone.limit};
+    }
+}
+
+void SpeedLimitIndex::reset() {
+    cursor_ = 0;
+    position_ = 0;
+}
+
+// 向きを変えたら次の update() で先頭から辿り直す (折り返した表がなければ false)
+bool SpeedLimitIndex::setReversed(bool is_reversed) {
+    if (reversed_ == NULL || zones_ == NULL) return false;
+    zones_ = is_reversed ? reversed_ : forward_;
+    reset();
+    return true;
+}
+
+uint32_t SpeedLimitIndex::period() {
+    return period_;
+}
+
+// カーソルを現在位置以降で最初に終わる区間まで進める (区間が変わったらtrue)
+bool SpeedLimitIndex::update(uint32_t position) {
+    int16_t before = zone();
+
+    if (period_ > 0) position %= period_;
+    if (position < position_) cursor_ = 0;      // 周回して先頭に戻った
+    position_ = position;
+
+    while (cursor_ < count_ && zones_[cursor_].end <= position_) cursor_++;
+
+    return zone() != before;
+}
+
+int16_t SpeedLimitIndex::zone() {
+    if (cursor_ >= count_ || zones_[cursor_].start > position_) return -1;
+    return cursor_;
+}
+
+int8_t SpeedLimitIndex::limit() {
+    int16_t index = zone();
+    return index >= 0 ? zones_[index].limit : SPEED_LIMIT_NONE;
+}
+
+// 次に入る区間の制限と、そこまでの距離
+bool SpeedLimitIndex::nextLimit(int8_t *limit, uint32_t *distance) {
+    uint16_t next = zone() >= 0 ? cursor_ + 1 : cursor_;
+
+    if (next < count_) {
+        *limit = zones_[next].limit;
+        *distance = zones_[next].start - position_;
+        return true;
+    }
+
+    // 周回する場合は先頭の区間が次になる
+    if (period_ > 0 && count_ > 0 && zones_[0].start + period_ > position_) {
+        *limit = zones_[0].limit;
+        *distance = zones_[0].start + period_ - position_;
+        return true;
+    }
+    return false;
+}
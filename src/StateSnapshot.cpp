@@ -0,0 +1,40 @@
+#include <stddef.h>
+#include "StateSnapshot.h"
+#include "Crc16.h"
+
+const uint8_t StateSnapshot::FLAG_LEFT = 0x01;
+const uint8_t StateSnapshot::FLAG_EVACUTE = 0x02;
+const uint8_t StateSnapshot::DECEL_SIZE_MAX = 10;
+
+uint16_t StateSnapshot::checksum(const StateSnapshot_t &snapshot) {
+    return crc16Ccitt((const uint8_t *)&snapshot, offsetof(StateSnapshot_t, crc));
+}
+
+void StateSnapshot::encode(const ControllerState_t &state, StateSnapshot_t *snapshot) {
+    snapshot->magic = STATE_SNAPSHOT_MAGIC;
+    snapshot->version = STATE_SNAPSHOT_VERSION;
+    snapshot->flags = (state.is_left ? FLAG_LEFT : 0) | (state.is_evacute ? FLAG_EVACUTE : 0);
+    snapshot->decel_size = state.decel_size;
+    snapshot->reserved = 0;
+    snapshot->crc = checksum(*snapshot);
+}
+
+bool StateSnapshot::decode(const StateSnapshot_t &snapshot, ControllerState_t *state) {
+    if (snapshot.magic != STATE_SNAPSHOT_MAGIC) return false;
+    if (snapshot.version != STATE_SNAPSHOT_VERSION) return false;
+    if (snapshot.crc != checksum(snapshot)) return false;
+
+    // CRCが一致しても範囲外の値は採用しない
+    if ((snapshot.flags & ~(FLAG_LEFT | FLAG_EVACUTE)) != 0) return false;
+    if (snapshot.decel_size > DECEL_SIZE_MAX) return false;
+
+    state->is_left = (snapshot.flags & FLAG_LEFT) != 0;
+    state->is_evacute = (snapshot.flags & FLAG_EVACUTE) != 0;
+    state->decel_size = snapshot.decel_size;
+    return true;
+}
+
+void StateSnapshot::invalidate(StateSnapshot_t *snapshot) {
+    snapshot->magic = 0;
+    snapshot->crc = 0;
+}
@@ -0,0 +1,164 @@
+#include "StripChart.h"
+#include "hal/Hal.h"
+
+const int8_t StripChart::NOTCH_MIN = -9;
+const int8_t StripChart::NOTCH_MAX = 5;
+const uint8_t StripChart::RESISTANCE_MAX = 10;
+const uint16_t StripChart::GRID_INTERVAL = 40;
+
+StripChart::StripChart(uint8_t samples_per_column):
+    columns_total_(0),
+    rendered_total_(0),
+    is_invalid_(false),
+    pending_samples_(0),
+    samples_per_column_(samples_per_column),
+    max_speed_(127),
+    render_us_(0),
+    last_render_us_(0),
+    max_render_us_(0),
+    reported_lap_(0) {
+
+}
+
+void StripChart::begin(int16_t height, int8_t max_speed) {
+    max_speed_ = max_speed;
+    canvas_.setColorDepth(8);
+    canvas_.setBaseColor(BLACK);
+    canvas_.createSprite(STRIP_CHART_COLUMNS, height);
+    canvas_.clear();
+}
+
+int16_t StripChart::speedToY(int8_t speed) {
+    if (speed < 0) speed = 0;
+    else if (speed > max_speed_) speed = max_speed_;
+    return (canvas_.height() - 1) - (int32_t)(canvas_.height() - 1) * speed / max_speed_;
+}
+
+int16_t StripChart::notchToY(int8_t notch) {
+    if (notch < NOTCH_MIN) notch = NOTCH_MIN;
+    else if (notch > NOTCH_MAX) notch = NOTCH_MAX;
+    return (canvas_.height() - 1) - (int32_t)(canvas_.height() - 1) * (notch - NOTCH_MIN) / (NOTCH_MAX - NOTCH_MIN);
+}
+
+int16_t StripChart::resistanceToY(uint8_t resistance) {
+    if (resistance > RESISTANCE_MAX) resistance = RESISTANCE_MAX;
+    return (canvas_.height() - 1) - (int32_t)(canvas_.height() - 1) * resistance / RESISTANCE_MAX;
+}
+
+void StripChart::drawGrid(int16_t x, bool is_marker) {
+    if (is_marker) {
+        canvas_.drawFastVLine(x, 0, canvas_.height(), DARKGREY);
+        return;
+    }
+
+    // 速度25%刻みとノッチ0の位置に目盛り
+    for (uint8_t i = 1; i < 4; i++) {
+        canvas_.drawPixel(x, speedToY(max_speed_ * i / 4), DARKGREY);
+    }
+    canvas_.drawPixel(x, notchToY(0), NAVY);
+}
+
+void StripChart::drawColumn(int16_t x, const Column_t &prev, const Column_t &curr) {
+    canvas_.drawLine(x - 1, resistanceToY(prev.resistance), x, resistanceToY(curr.resistance), YELLOW);
+    canvas_.drawLine(x - 1, notchToY(prev.notch), x, notchToY(curr.notch), curr.notch < 0 ? ORANGE : CYAN);
+
+    int16_t y_top = speedToY(curr.speed_max);
+    int16_t y_bottom = speedToY(curr.speed_min);
+    canvas_.drawLine(x - 1, speedToY(prev.speed_max), x, y_top, GREEN);
+    canvas_.drawFastVLine(x, y_top, y_bottom - y_top + 1, GREEN);
+}
+
+// 既存の画素を1列左へずらし、column 列目だけを描く
+void StripChart::renderColumn(uint32_t column) {
+    const Column_t &curr = ring_[column % STRIP_CHART_COLUMNS];
+    const Column_t &prev = column > 0 ? ring_[(column - 1) % STRIP_CHART_COLUMNS] : curr;
+
+    canvas_.scroll(-1, 0);
+    drawGrid(STRIP_CHART_COLUMNS - 1, (column + 1) % GRID_INTERVAL == 0);
+    drawColumn(STRIP_CHART_COLUMNS - 1, prev, curr);
+}
+
+bool StripChart::addSample(int8_t speed, int8_t notch, uint8_t resistance) {
+    if (pending_samples_ == 0) {
+        pending_.speed_min = speed;
+        pending_.speed_max = speed;
+    } else {
+        if (speed < pending_.speed_min) pending_.speed_min = speed;
+        if (speed > pending_.speed_max) pending_.speed_max = speed;
+    }
+    pending_.notch = notch;
+    pending_.resistance = resistance;
+
+    if (++pending_samples_ < samples_per_column_) return false;
+    pending_samples_ = 0;
+
+    uint32_t total = columns_total_;
+    ring_[total % STRIP_CHART_COLUMNS] = pending_;
+    columns_total_ = total + 1;
+    return true;
+}
+
+// 溜まった列をまとめて描き、1回だけ転送する
+// 1周分以上遅れていれば描き直す (描いている間に上書きされた最古の列は次の描き直しで直る)
+bool StripChart::update(LovyanGFX *dst, int32_t x, int32_t y) {
+    uint32_t total = columns_total_;
+    if (!is_invalid_ && total == rendered_total_) return false;
+
+    if (is_invalid_ || total - rendered_total_ >= STRIP_CHART_COLUMNS) {
+        redraw();
+    } else {
+        uint32_t start = micros();
+        for (; rendered_total_ != total; rendered_total_++) renderColumn(rendered_total_);
+        render_us_ = micros() - start;
+    }
+
+    push(dst, x, y);
+    return true;
+}
+
+void StripChart::invalidate() {
+    is_invalid_ = true;
+}
+
+void StripChart::redraw() {
+    uint32_t start = micros();
+    uint32_t total = columns_total_;
+    uint32_t count = total < STRIP_CHART_COLUMNS ? total : STRIP_CHART_COLUMNS;
+
+    canvas_.clear();
+
+    int16_t x = STRIP_CHART_COLUMNS - count;
+    for (uint32_t column = total - count; column != total; column++, x++) {
+        const Column_t &curr = ring_[column % STRIP_CHART_COLUMNS];
+        const Column_t &prev = column > total - count ? ring_[(column - 1) % STRIP_CHART_COLUMNS] : curr;
+        drawGrid(x, (column + 1) % GRID_INTERVAL == 0);
+        drawColumn(x, prev, curr);
+    }
+
+    rendered_total_ = total;
+    is_invalid_ = false;
+    render_us_ = micros() - start;
+}
+
+void StripChart::push(LovyanGFX *dst, int32_t x, int32_t y) {
+    uint32_t start = micros();
+    canvas_.pushSprite(dst, x, y);
+    last_render_us_ = render_us_ + micros() - start;
+    render_us_ = 0;
+
+    if (last_render_us_ > max_render_us_) max_render_us_ = last_render_us_;
+
+    uint32_t lap = rendered_total_ / STRIP_CHART_COLUMNS;
+    if (lap != reported_lap_) {
+        reported_lap_ = lap;
+        hal::log("chart render: last %u us / max %u us\n", last_render_us_, max_render_us_);
+    }
+}
+
+uint32_t StripChart::lastRenderMicros() {
+    return last_render_us_;
+}
+
+uint32_t StripChart::maxRenderMicros() {
+    return max_render_us_;
+}
@@ -0,0 +1,110 @@
+#include "TargetStop.h"
+#include "hal/Hal.h"
+
+TargetStop::TargetStop(const NotchTableStore *tables):
+    tables_(tables),
+    built_(NULL),
+    mode_(MODE_OFF),
+    is_armed_(false),
+    is_braking_(false),
+    position_(0),
+    target_(0),
+    recommended_(0) {
+
+}
+
+void TargetStop::rebuild(const NotchTable_t *table) {
+    for (uint8_t n = 0; n < BRAKE_NOTCH_NUM; n++) {
+        for (uint8_t v = 0; v < TARGET_STOP_SPEED_NUM; v++) {
+            distance_[n][v] = SpeedControl::brakingDistance(table->brake[n], v);
+        }
+    }
+    built_ = table;
+}
+
+void TargetStop::setMode(Mode_t mode) {
+    mode_ = mode;
+}
+
+TargetStop::Mode_t TargetStop::mode() {
+    return mode_;
+}
+
+// マーカー(ボタンやセンサー)の位置から目標までの距離を設定する
+void TargetStop::mark(uint32_t target_distance) {
+    position_ = 0;
+    target_ = target_distance;
+    is_armed_ = true;
+    is_braking_ = false;
+    recommended_ = 0;
+}
+
+void TargetStop::clear() {
+    is_armed_ = false;
+    is_braking_ = false;
+    recommended_ = 0;
+}
+
+// 制御ティック毎に呼ぶ (テーブル参照はノッチ数分だけ)
+int8_t TargetStop::tick(int8_t speed) {
+    if (tables_->active() != built_) {
+        const NotchTable_t *table = tables_->acquire();
+        rebuild(table);
+        tables_->release(table);
+    }
+
+    if (!is_armed_ || speed < 0) return recommended_ = 0;
+
+    position_ += speed;
+
+    if (speed == 0) {
+        // 動いた後に止まったら結果を残して解除する
+        if (position_ > 0) {
+            hal::log("target stop: error %ld\n", (long)position_ - (long)target_);
+            clear();
+        }
+        return recommended_ = 0;
+    }
+
+    uint32_t remaining = position_ < target_ ? target_ - position_ : 0;
+
+    // 最弱のブレーキでも手前に止まるうちはブレーキ不要、一度掛け始めたら緩めない
+    if (!is_braking_ && distance_[0][speed] < remaining) return recommended_ = 0;
+    is_braking_ = true;
+
+    for (uint8_t n = 0; n < BRAKE_NOTCH_NUM - 1; n++) {
+        if (distance_[n][speed] <= remaining) return recommended_ = -(n + 1);
+    }
+    return recommended_ = NOTCH_EMERGENCY;
+}
+
+// 自動モードではハンドルと推奨ノッチの強い方を使う
+int8_t TargetStop::apply(int8_t notch) {
+    if (mode_ != MODE_APPLY || !is_armed_ || recommended_ == 0) return notch;
+    if (notch == NOTCH_INVALID) return notch;
+    if (notch == NOTCH_EMERGENCY) return notch;
+    if (recommended_ == NOTCH_EMERGENCY || notch > recommended_) return recommended_;
+    return notch;
+}
+
+bool TargetStop::is_armed() {
+    return is_armed_;
+}
+
+int8_t TargetStop::recommended() {
+    return recommended_;
+}
+
+uint32_t TargetStop::position() {
+    return position_;
+}
+
+uint32_t TargetStop::target() {
+    return target_;
+}
+
+uint32_t TargetStop::stoppingDistance(int8_t notch, int8_t speed) {
+    if (notch >= 0 || notch < NOTCH_EMERGENCY) return UINT32_MAX;
+    if (speed < 0) speed = 0;
+    return distance_[-notch - 1][speed];
+}
@@ -0,0 +1,75 @@
+#include <string.h>
+#include "Telemetry.h"
+#include "Crc16.h"
+
+Telemetry::Telemetry(hal::TelemetryPort *port):
+    port_(port),
+    seq_(0),
+    is_dropped_(false),
+    dropped_(0),
+    frame_len_(0),
+    frame_pos_(0) {
+
+}
+
+// 溢れたら捨てて数えるだけで、呼び出し側を待たせない
+bool Telemetry::push(TelemetryTick_t record) {
+    record.seq = seq_++;
+    if (is_dropped_) record.flags |= TELEMETRY_FLAG_DROPPED;
+
+    if (!ring_.push(record)) {
+        is_dropped_ = true;
+        dropped_++;
+        return false;
+    }
+    is_dropped_ = false;
+    return true;
+}
+
+uint32_t Telemetry::dropped() {
+    return dropped_;
+}
+
+// 送信先の空きに収まるフレームだけを書く (UARTの空きを待たず、フレームを分けない)
+// ログの行は数が少ないので記録より先に送る
+void Telemetry::drain() {
+    while (true) {
+        if (frame_pos_ >= frame_len_) {
+            char line[TELEMETRY_LOG_MAX + 1];
+            TelemetryTick_t record;
+            size_t len = hal::readLog(line, sizeof(line));
+
+            if (len > 0) {
+                frame_len_ = encodeFrame(TELEMETRY_TYPE_LOG, (const uint8_t *)line, len, frame_);
+            } else if (ring_.pop(&record)) {
+                frame_len_ = encodeFrame(TELEMETRY_TYPE_TICK, (const uint8_t *)&record, sizeof(record), frame_);
+            } else {
+                return;
+            }
+            frame_pos_ = 0;
+        }
+
+        // 書けた長さが足りなければ残りを次の呼び出しで書く (送信先が空きどおりに書けなかった場合だけ)
+        size_t len = frame_len_ - frame_pos_;
+        if (port_->writable() < len) return;
+
+        frame_pos_ += port_->write(&frame_[frame_pos_], len);
+        if (frame_pos_ < frame_len_) return;
+    }
+}
+
+size_t Telemetry::encodeFrame(uint8_t type, const uint8_t *payload, size_t len, uint8_t *out) {
+    uint8_t raw[1 + TELEMETRY_PAYLOAD_MAX + 2];
+    if (len > TELEMETRY_PAYLOAD_MAX) return 0;
+
+    raw[0] = type;
+    memcpy(&raw[1], payload, len);
+    uint16_t crc = crc16Ccitt(raw, 1 + len);
+    raw[1 + len] = crc & 0xFF;
+    raw[2 + len] = crc >> 8;
+
+    out[0] = 0x00;
+    size_t encoded = cobsEncode(raw, 3 + len, &out[1]);
+    out[1 + encoded] = 0x00;
+    return encoded + 2;
+}
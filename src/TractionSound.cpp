@@ -0,0 +1,128 @@
+#include <math.h>
+#include "TractionSound.h"
+
+// 速度1あたりのモーター回転周波数 (1/16Hz単位)
+#define MOTOR_HZ16_PER_SPEED        26
+#define HUM_LEVEL_PER_SPEED         60
+#define GLIDE_SHIFT                 2
+
+const uint8_t TractionSound::SINE_TABLE_BITS = 8;
+const int32_t TractionSound::FM_DEPTH = 41722;    // 変調指数 約2rad
+const uint16_t TractionSound::ASYNC_SPEED_MAX = 24;
+// 非同期モードのキャリア周波数 (起動時の音階)
+const uint16_t TractionSound::ASYNC_CARRIER_HZ[9] = {
+    349, 392, 440, 466, 523, 587, 659, 698, 784
+};
+const int32_t TractionSound::RELEASE_LEVEL = 6000;
+const int32_t TractionSound::RELEASE_DECAY_Q15 = 32760;
+
+TractionSound::TractionSound(uint32_t sample_rate):
+    sample_rate_(sample_rate),
+    speed_(0),
+    notch_(0),
+    before_notch_(0),
+    phase_carrier_(0),
+    phase_motor_(0),
+    inc_carrier_(0),
+    inc_motor_(0),
+    level_whine_(0),
+    level_hum_(0),
+    level_release_(0),
+    lfsr_(0xACE1) {
+    for (uint16_t i = 0; i < (1 << SINE_TABLE_BITS); i++) {
+        float rad = 2.0f * (float)M_PI * i / (1 << SINE_TABLE_BITS);
+        sine_[i] = (int16_t)(32767.0f * sinf(rad));
+        // 基本波 + 2倍 + 3倍高調波のうなり
+        float hum = sinf(rad) + 0.5f * sinf(2 * rad) + 0.33f * sinf(3 * rad);
+        hum_wave_[i] = (int16_t)(32767.0f * hum / 1.6f);
+    }
+}
+
+void TractionSound::setState(int8_t speed, int8_t notch) {
+    speed_ = speed;
+    notch_ = notch;
+}
+
+uint32_t TractionSound::hzToIncrement(uint32_t hz_x16) {
+    return (uint32_t)(((uint64_t)hz_x16 << 28) / sample_rate_);
+}
+
+uint32_t TractionSound::carrierHz16(int8_t speed) {
+    if (speed <= ASYNC_SPEED_MAX) {
+        return ASYNC_CARRIER_HZ[speed * 9 / (ASYNC_SPEED_MAX + 1)] * 16;
+    }
+
+    // 同期モード: 速度に応じてパルス数を切り替え
+    uint32_t motor_hz16 = speed * MOTOR_HZ16_PER_SPEED;
+    if (speed < 40) return motor_hz16 * 15;
+    if (speed < 55) return motor_hz16 * 9;
+    if (speed < 70) return motor_hz16 * 5;
+    return motor_hz16 * 3;
+}
+
+int32_t TractionSound::whineLevel(int8_t speed, int8_t notch) {
+    if (speed <= 0) return 0;
+
+    int32_t level = 0;
+    if (notch > 0) {
+        level = 2000 + notch * 800;          // 力行
+    } else if (notch < 0 && notch > -9) {
+        level = 1200 + (-notch) * 150;       // 回生ブレーキ
+    }
+
+    if (speed < 4) level = level * speed / 4;
+    return level;
+}
+
+int16_t TractionSound::nextNoise() {
+    uint16_t lsb = lfsr_ & 1;
+    lfsr_ >>= 1;
+    if (lsb) lfsr_ ^= 0xB400;
+    return (int16_t)lfsr_;
+}
+
+void TractionSound::render(int16_t *buffer, size_t samples) {
+    int8_t speed = speed_;
+    int8_t notch = notch_;
+    if (speed < 0) speed = 0;
+
+    // ブレーキ緩解時の空気音
+    if (before_notch_ < 0 && notch >= 0) {
+        level_release_ = RELEASE_LEVEL;
+    }
+    before_notch_ = notch;
+
+    uint32_t target_motor = hzToIncrement(speed * MOTOR_HZ16_PER_SPEED);
+    uint32_t target_carrier = speed > 0 ? hzToIncrement(carrierHz16(speed)) : inc_carrier_;
+    inc_motor_ += (int32_t)(target_motor - inc_motor_) >> GLIDE_SHIFT;
+    inc_carrier_ += (int32_t)(target_carrier - inc_carrier_) >> GLIDE_SHIFT;
+
+    int32_t target_whine = whineLevel(speed, notch);
+    int32_t target_hum = speed * HUM_LEVEL_PER_SPEED;
+    int32_t step_whine = (target_whine - level_whine_) / (int32_t)samples;
+    int32_t step_hum = (target_hum - level_hum_) / (int32_t)samples;
+
+    const uint8_t shift = 32 - SINE_TABLE_BITS;
+    for (size_t i = 0; i < samples; i++) {
+        level_whine_ += step_whine;
+        level_hum_ += step_hum;
+        phase_motor_ += inc_motor_;
+        phase_carrier_ += inc_carrier_;
+
+        int32_t mod = FM_DEPTH * sine_[phase_motor_ >> shift];
+        int32_t out = (level_whine_ * sine_[(phase_carrier_ + (uint32_t)mod) >> shift]) >> 15;
+        out += (level_hum_ * hum_wave_[phase_motor_ >> shift]) >> 15;
+
+        if (level_release_ > 0) {
+            out += (level_release_ * nextNoise()) >> 15;
+            level_release_ = (level_release_ * RELEASE_DECAY_Q15) >> 15;
+        }
+
+        if (out > INT16_MAX) out = INT16_MAX;
+        else if (out < INT16_MIN) out = INT16_MIN;
+        buffer[i] = (int16_t)out;
+    }
+
+    level_whine_ = target_whine;
+    level_hum_ = target_hum;
+}
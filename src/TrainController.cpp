@@ -3,35 +3,65 @@
 const uint8_t TrainController::IDX_SPEED = 0;
 const uint8_t TrainController::IDX_POINT_LEFT = 2;
 const uint8_t TrainController::IDX_POINT_RIGHT = 3;
-
-TrainController::TrainController() {
+const uint32_t TrainController::PROBE_INTERVAL_MS = 20;
+// プロファイルなしは従来どおり速度をそのままPWM値にする
+const LocoProfile_t TrainController::NO_PROFILE = {0, 0, 0};
+
+TrainController::TrainController(hal::MotorPort *port, const LocoProfiles_t *profiles): port_(port), profiles_(profiles) {
+    is_available_ = false;
+    is_feeder_cut_ = false;
+    is_switching_ = false;
     is_waiting_line_ = false;
     run_back_ = 0;
-    speed_ = 0;
+    speed_q8_ = 0;
+    output_ = 0;
+    last_speed_q8_ = 0;
+    dither_acc_ = 0;
+    kick_remain_ = 0;
+}
+
+void TrainController::restore(bool run_back, bool is_waiting_line) {
+    if (is_available_) return;
+
+    run_back_ = run_back;
+    is_waiting_line_ = is_waiting_line;
 }
 
-void TrainController::begin() {
-    while (!driver_.begin(&Wire, MODULE_4ENCODERMOTOR_ADDR, 21, 22)) {
-        Serial.println("failed to begin motor driver");
-        delay(100);
+bool TrainController::begin(uint32_t timeout_ms, bool output_point) {
+    uint32_t start = hal::millis();
+    while (!port_->begin()) {
+        if (hal::millis() - start >= timeout_ms) {
+            hal::log("failed to begin motor driver\n");
+            return false;
+        }
+        hal::delayMs(PROBE_INTERVAL_MS);
     }
 
     uint8_t version;
-    bool ret = driver_.getFirmwareVersion(&version);
-    Serial.printf("ret: %d / version: %d / addr: %02X\n", ret, version, driver_.getI2CAddress());
+    bool ret = port_->getFirmwareVersion(&version);
+    hal::log("ret: %d / version: %d / addr: %02X\n", ret, version, port_->getAddress());
+
 
 
+    port_->setNormalMode(IDX_SPEED);
+    port_->setMotorSpeed(IDX_SPEED, 0);
+    speed_q8_ = 0;
+    output_ = 0;
 
-    driver_.setMode(IDX_SPEED, NORMAL_MODE);
-    driver_.setMotorSpeed(IDX_SPEED, 0);
+    port_->setNormalMode(IDX_POINT_LEFT);
+    port_->setNormalMode(IDX_POINT_RIGHT);
+    if (output_point) outputSwitch();
+
+    is_available_ = true;
+    return true;
+}
 
-    driver_.setMode(IDX_POINT_LEFT, NORMAL_MODE);
-    driver_.setMode(IDX_POINT_RIGHT, NORMAL_MODE);
-    outputSwitch();
+bool TrainController::is_available() {
+    return is_available_;
 }
 
 bool TrainController::is_running() {
-    return speed_ > 0;
+    return speed_q8_ > 0;
 }
 
 bool TrainController::run_back() {
@@ -50,20 +80,101 @@ void TrainController::switchDirection() {
 }
 
 int8_t TrainController::current_speed() {
-    return speed_;
+    return speed_q8_ >> 8;
 }
 
 void TrainController::setSpeed(int8_t speed) {
     if (speed < 0) speed = 0;
-    if (speed == speed_) return;
-    speed_ = speed;
+    setSpeedQ8((uint16_t)speed << 8);
+}
+
+// 出力は service() がフレーム毎にまとめて書く (起動時のキックも service() で判定する)
+// 速度の小数部 (1/256) はPWMのディザで出すので、低速でも段差にならない
+void TrainController::setSpeedQ8(uint16_t speed_q8) {
+    if (speed_q8 > (127 << 8)) speed_q8 = 127 << 8;
+    speed_q8_ = speed_q8;
+}
+
+// 短絡時に出力だけを止める (速度の指示はそのまま保持する)
+void TrainController::cutFeeder() {
+    is_feeder_cut_ = true;
+    if (!is_available_) return;
+    port_->setMotorSpeed(IDX_SPEED, 0);
+    output_ = 0;
+}
+
+// 次のフレームで今の速度を書き直す
+void TrainController::restoreFeeder() {
+    is_feeder_cut_ = false;
+}
+
+// 速度(0-127, 下位8bitは小数部)を動き出し値から127までに割り当てたPWM値 (下位8bitは小数部)
+uint16_t TrainController::outputLevel(uint16_t speed_q8, const LocoProfile_t &profile) {
+    if (speed_q8 == 0) return 0;
+
+    uint32_t base = profile.min_start < 127 ? profile.min_start : 126;
+    return (base << 8) + (uint32_t)speed_q8 * (127 - base) / 127;
+}
+
+const LocoProfile_t &TrainController::profile() {
+    if (profiles_ == NULL) return NO_PROFILE;
+
+    uint8_t index = profiles_->selected - 1;
+    return index < LOCO_PROFILE_NUM ? profiles_->loco[index] : NO_PROFILE;
+}
+
+// 1フレーム分の出力 (出力タスクの周期で呼ぶ)
+// 小数部は隣り合うPWM値を1次のΣΔで切り替えて時間平均で出す。
+// 書き込みは値が変わるフレームだけで、1フレームに速度チャンネルへ1回を超えない
+void TrainController::service() {
+    if (!is_available_ || is_feeder_cut_) return;
+
+    const LocoProfile_t &loco = profile();
+    uint16_t speed_q8 = speed_q8_;  // このフレームはこの値で出す
+    uint16_t level = outputLevel(speed_q8, loco);
+    int8_t code = level >> 8;
+
+    // 停止から動き出したフレームでキックを始める
+    if (last_speed_q8_ == 0 && speed_q8 != 0) kick_remain_ = loco.kick_frames;
+    last_speed_q8_ = speed_q8;
+
+    if (speed_q8 == 0) {
+        kick_remain_ = 0;
+        dither_acc_ = 0;
+    } else if (kick_remain_ > 0) {
+        kick_remain_--;
+        if (loco.kick_level > code) code = loco.kick_level;
+    } else {
+        dither_acc_ += level & 0xFF;
+        if (dither_acc_ >= 0x100) {
+            dither_acc_ -= 0x100;
+            code++;
+        }
+    }
+
+    int8_t value = code * (run_back_ ? -1 : 1);
+    if (value == output_) return;
+    port_->setMotorSpeed(IDX_SPEED, value);
+    output_ = value;
+
+    // 書き込み中に遮断された場合は止め直す
+    if (is_feeder_cut_) {
+        port_->setMotorSpeed(IDX_SPEED, 0);
+        output_ = 0;
+    }
+}
+
+bool TrainController::is_feeder_cut() {
+    return is_feeder_cut_;
+}
 
-    int8_t value = speed_ * (run_back_ ? -1 : 1);
-    driver_.setMotorSpeed(IDX_SPEED, value);
+// ポイントの駆動電流は短絡と区別できないので、この間は監視しない
+bool TrainController::is_switching() {
+    return is_switching_;
 }
 
 void TrainController::accelSpeed(int8_t speed) {
-    int next = speed_ + speed;
+    int next = current_speed() + speed;
     if (next > 127) next = 127;
     else if (next < 0) next = 0;
 
@@ -71,7 +182,7 @@ void TrainController::accelSpeed(int8_t speed) {
 }
 
 void TrainController::brakeSpeed(int8_t speed) {
-    int next = speed_ - speed;
+    int next = current_speed() - speed;
     if (next > 127) next = 127;
     else if (next < 0) next = 0;
 
@@ -85,19 +196,21 @@ bool TrainController::is_waiting_lien() {
 void TrainController::setPointState(bool is_wating_line) {
     if (is_running()) return;
     is_waiting_line_ = is_wating_line;
-    outputSwitch();
+    if (is_available_) outputSwitch();
 }
 
 void TrainController::switchPoint() {
     is_waiting_line_ = !is_waiting_line_;
-    outputSwitch();
+    if (is_available_) outputSwitch();
 }
 
 void TrainController::outputSwitch() {
     int8_t pwm = is_waiting_line_ ? -127 : 127;
-    driver_.setMotorSpeed(IDX_POINT_LEFT, pwm);
-    driver_.setMotorSpeed(IDX_POINT_RIGHT, pwm);
-    delay(50);
-    driver_.setMotorSpeed(IDX_POINT_LEFT, 0);
-    driver_.setMotorSpeed(IDX_POINT_RIGHT, 0);
+    is_switching_ = true;
+    port_->setMotorSpeed(IDX_POINT_LEFT, pwm);
+    port_->setMotorSpeed(IDX_POINT_RIGHT, pwm);
+    hal::delayMs(50);
+    port_->setMotorSpeed(IDX_POINT_LEFT, 0);
+    port_->setMotorSpeed(IDX_POINT_RIGHT, 0);
+    is_switching_ = false;
 }
\ No newline at end of file
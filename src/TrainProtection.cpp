@@ -0,0 +1,166 @@
+#include <stddef.h>
+#include "TrainProtection.h"
+#include "hal/Hal.h"
+
+// 許容速度からの超過量と介入ノッチ (上から順に強くなる)
+const TrainProtection::Step_t TrainProtection::STEPS[] = {
+    {1, 0},                 // 力行遮断
+    {3, -2},
+    {6, -4},
+    {10, -7},
+    {20, NOTCH_EMERGENCY},
+};
+const uint8_t TrainProtection::STEP_NUM = sizeof(STEPS) / sizeof(STEPS[0]);
+const uint8_t TrainProtection::SERVICE_BRAKE = 4;   // ブレーキ曲線はB4で描く
+const int8_t TrainProtection::RELEASE_MARGIN = 2;   // 許容速度をこれだけ下回ったら緩解
+
+TrainProtection::TrainProtection(const NotchTableStore *tables, SpeedLimitIndex *position_zones, SpeedLimitIndex *time_zones):
+    tables_(tables),
+    built_(NULL),
+    position_zones_(position_zones),
+    time_zones_(time_zones),
+    is_enabled_(false),     // 区間表をレイアウトに合わせて原点を決めるまでは切っておく
+    is_reversed_(false),
+    max_speed_(SPEED_LIMIT_NONE),
+    position_(0),
+    allowed_speed_(SPEED_LIMIT_NONE),
+    intervention_(TRAIN_PROTECTION_NOTCH_FREE),
+    intervention_count_(0) {
+
+}
+
+void TrainProtection::rebuild(const NotchTable_t *table) {
+    for (uint8_t v = 0; v < TRAIN_PROTECTION_SPEED_NUM; v++) {
+        curve_[v] = SpeedControl::brakingDistance(table->brake[SERVICE_BRAKE - 1], v);
+    }
+    built_ = table;
+}
+
+void TrainProtection::setEnabled(bool is_enabled) {
+    is_enabled_ = is_enabled;
+}
+
+bool TrainProtection::is_enabled() {
+    return is_enabled_;
+}
+
+void TrainProtection::setMaxSpeed(int8_t max_speed) {
+    max_speed_ = max_speed;
+}
+
+// 逆向きでは原点から反対周りに距離を数える (周回の長さで折り返す)
+void TrainProtection::setReversed(bool is_reversed) {
+    if (is_reversed == is_reversed_) return;
+    is_reversed_ = is_reversed;
+
+    // 折り返した区間表がなければ片方向のまま数える
+    if (position_zones_ == NULL || !position_zones_->setReversed(is_reversed)) return;
+    uint32_t lap = position_zones_->period();
+    position_ = (lap - position_ % lap) % lap;
+}
+
+// 周回の原点に合わせる
+void TrainProtection::resetPosition() {
+    position_ = 0;
+    if (position_zones_ != NULL) position_zones_->reset();
+}
+
+// distance先で速度limitまで落とせる現在の最高速度 (停止距離表の二分探索)
+int8_t TrainProtection::curveSpeed(int8_t limit, uint32_t distance) {
+    if (limit < 0) limit = 0;
+    uint32_t budget = distance + curve_[limit];
+    uint8_t low = limit;
+    uint8_t high = TRAIN_PROTECTION_SPEED_NUM - 1;
+
+    while (low < high) {
+        uint8_t mid = (low + high + 1) / 2;
+        if (curve_[mid] <= budget) low = mid;
+        else high = mid - 1;
+    }
+    return low;
+}
+
+void TrainProtection::log(int8_t speed, int8_t notch) {
+    if (notch == TRAIN_PROTECTION_NOTCH_FREE) {
+        hal::log("atp: released at speed %d (allowed %d)\n", speed, allowed_speed_);
+    } else if (notch == NOTCH_EMERGENCY) {
+        hal::log("atp: speed %d / allowed %d -> EB\n", speed, allowed_speed_);
+    } else if (notch == 0) {
+        hal::log("atp: speed %d / allowed %d -> power cut\n", speed, allowed_speed_);
+    } else {
+        hal::log("atp: speed %d / allowed %d -> B%d\n", speed, allowed_speed_, -notch);
+    }
+}
+
+// 制御ティック毎に呼ぶ (区間はカーソルで辿り、曲線は7回の比較で求める)
+int8_t TrainProtection::tick(int8_t speed, uint32_t time_ms) {
+    if (tables_->active() != built_) {
+        const NotchTable_t *table = tables_->acquire();
+        rebuild(table);
+        tables_->release(table);
+    }
+
+    if (speed > 0) position_ += speed;
+
+    int8_t allowed = max_speed_;
+    int8_t next_limit;
+    uint32_t distance;
+
+    if (position_zones_ != NULL) {
+        position_zones_->update(position_);
+        if (position_zones_->limit() < allowed) allowed = position_zones_->limit();
+        if (position_zones_->nextLimit(&next_limit, &distance) && next_limit < allowed) {
+            int8_t curve = curveSpeed(next_limit, distance);
+            if (curve < allowed) allowed = curve;
+        }
+    }
+    if (time_zones_ != NULL) {
+        time_zones_->update(time_ms);
+        if (time_zones_->limit() < allowed) allowed = time_zones_->limit();
+    }
+    allowed_speed_ = allowed;
+
+    int8_t notch = TRAIN_PROTECTION_NOTCH_FREE;
+    if (is_enabled_) {
+        int16_t overspeed = speed - allowed;
+        for (uint8_t i = 0; i < STEP_NUM; i++) {
+            if (overspeed >= STEPS[i].overspeed) notch = STEPS[i].notch;
+        }
+
+        // 介入中は許容速度を十分下回るまで力行させない
+        if (notch == TRAIN_PROTECTION_NOTCH_FREE && intervention_ != TRAIN_PROTECTION_NOTCH_FREE && overspeed > -RELEASE_MARGIN) {
+            notch = 0;
+        }
+    }
+
+    // 介入の段階が変わる度に記録する (数字が小さいほど強い)
+    if (notch != intervention_) {
+        if (notch < intervention_) intervention_count_++;
+        log(speed, notch);
+        intervention_ = notch;
+    }
+    return intervention_;
+}
+
+// ハンドルと介入の強い方を使う
+int8_t TrainProtection::apply(int8_t notch) {
+    if (notch == NOTCH_INVALID || notch == NOTCH_EMERGENCY) return notch;
+    if (intervention_ == NOTCH_EMERGENCY) return NOTCH_EMERGENCY;
+    return notch < intervention_ ? notch : intervention_;
+}
+
+int8_t TrainProtection::allowed_speed() {
+    return allowed_speed_;
+}
+
+int8_t TrainProtection::intervention() {
+    return intervention_;
+}
+
+uint32_t TrainProtection::position() {
+    return position_;
+}
+
+uint32_t TrainProtection::intervention_count() {
+    return intervention_count_;
+}
@@ -1,26 +1,31 @@
 #include "display.h"
 
-const int8_t Display::SPEED_MIN = 0;
-const int8_t Display::SPEED_MAX = 127;
-const float Display::SPEED_START_DEG = 150;
-const float Display::SPEED_RANGE_DEG = 240;
-const float Display::SPEED_END_DEG = SPEED_START_DEG + SPEED_RANGE_DEG;
+const int16_t Display::PANEL_HEIGHT = 140;
+// 50msティック x 5 = 1列250ms, 240列で60秒分
+const uint8_t Display::CHART_SAMPLES_PER_COLUMN = 5;
 
-Display::Display(int8_t max_speed): 
-    max_speed_(max_speed),
-    before_speed_(0) {
+Display::Display():
+    display_(M5.Display),
+    chart_(CHART_SAMPLES_PER_COLUMN),
+    editor_(this),
+    is_chart_visible_(false),
+    is_suspended_(false),
+    is_assist_visible_(false) {
 
 }
 
-void Display::begin() {
-    display_.begin();
+void Display::begin(int8_t max_speed, NotchTableStore *tables, LocoProfiles_t *profiles) {
+    gauge_.setMaxSpeed(max_speed);
+    editor_.begin(tables, profiles);
+
+    // パネル自体はM5.begin()で初期化済みのものを使う (タッチ座標も同じ向きになる)
     display_.setRotation(0);
     display_.setBaseColor(BLACK);
     display_.clear();
 
     canvas_rail_.setColorDepth(8);
     canvas_rail_.setBaseColor(BLACK);
-    canvas_rail_.createSprite(display_.width(), 140);
+    canvas_rail_.createSprite(display_.width(), PANEL_HEIGHT);
     canvas_rail_.setTextColor(WHITE);
     canvas_rail_.setTextDatum(middle_center);
     canvas_rail_.setFont(&fonts::lgfxJapanGothic_40);
@@ -32,19 +37,59 @@ void Display::begin() {
     canvas_damp_.setTextColor(WHITE);
     canvas_damp_.setTextDatum(middle_center);
 
-    display_.fillArc(display_.width() / 2, display_.width() / 2, display_.width() / 2, display_.width() / 2 - 10, SPEED_START_DEG, SPEED_END_DEG, DARKGREY);
+    canvas_assist_.setColorDepth(8);
+    canvas_assist_.setBaseColor(BLACK);
+    canvas_assist_.createSprite(100, 20);
+    canvas_assist_.setFont(&fonts::lgfxJapanGothic_16);
+    canvas_assist_.setTextDatum(middle_center);
+
+    chart_.begin(PANEL_HEIGHT, max_speed);
+
+    display_.fillArc(display_.width() / 2, display_.width() / 2, display_.width() / 2, display_.width() / 2 - 10, SpeedGauge::START_DEG, SpeedGauge::END_DEG, DARKGREY);
+}
+
+// チャートの描画と転送は速度制御のティックではなくここで行う
+void Display::poll() {
+    M5.update();
+    editor_.update();
+    if (is_chart_visible_ && !is_suspended_) {
+        chart_.update(&display_, 0, display_.height() - PANEL_HEIGHT);
+    }
+}
+
+LovyanGFX *Display::gfx() {
+    return &display_;
+}
+
+void Display::setSuspended(bool is_suspended) {
+    if (is_suspended == is_suspended_) return;
+    is_suspended_ = is_suspended;
+    if (is_suspended_) return;
+
+    // 中断中に更新された内容で全体を描き直す
+    display_.clear();
+    display_.fillArc(display_.width() / 2, display_.width() / 2, display_.width() / 2, display_.width() / 2 - 10, SpeedGauge::START_DEG, SpeedGauge::END_DEG, DARKGREY);
+    gauge_.invalidate();
+    setSpeed(gauge_.speed(), true);
+
+    if (is_chart_visible_) {
+        chart_.invalidate();    // 次の poll() で描き直す
+    } else {
+        canvas_rail_.pushSprite(&display_, 0, display_.height() - canvas_rail_.height());
+    }
+    canvas_damp_.pushSprite(&display_, 70, 70);
+    if (is_assist_visible_) canvas_assist_.pushSprite(&display_, 70, 160);
 }
 
 void Display::setSpeed(int8_t speed, bool is_push) {
-    if (speed < SPEED_MIN) speed = 0;
-    else if (speed > max_speed_) speed = max_speed_;
-    float deg = SPEED_START_DEG + SPEED_RANGE_DEG * speed / max_speed_;
-    // canvas_speed_.clear();
-    if (speed > before_speed_)
-        display_.fillArc(display_.width() / 2, display_.width() / 2, display_.width() / 2, display_.width() / 2 - 10, SPEED_START_DEG, deg, GREEN);
-    if (speed < before_speed_)
-        display_.fillArc(display_.width() / 2, display_.width() / 2, display_.width() / 2, display_.width() / 2 - 10, deg, SPEED_END_DEG, DARKGREY);
-    before_speed_ = speed;
+    SpeedGauge::Arc_t arc;
+
+    gauge_.setSpeed(speed);
+    if (is_suspended_) return;
+
+    if (gauge_.nextArc(&arc)) {
+        display_.fillArc(display_.width() / 2, display_.width() / 2, display_.width() / 2, display_.width() / 2 - 10, arc.start_deg, arc.end_deg, arc.is_fill ? GREEN : DARKGREY);
+    }
 }
 
 void Display::drawRail(bool is_left, bool is_evacute, bool is_push) {
@@ -68,7 +113,7 @@ void Display::drawRail(bool is_left, bool is_evacute, bool is_push) {
         canvas_rail_.drawString("右周り", canvas_rail_.width() / 2, 75);
     }
 
-    if (is_push) {
+    if (is_push && !is_chart_visible_ && !is_suspended_) {
         canvas_rail_.pushSprite(&display_, 0, display_.height() - canvas_rail_.height());
     }
 }
@@ -80,5 +125,48 @@ void Display::drawDamp(uint8_t damp) {
     sprintf(buff, "%d", damp);
     canvas_damp_.drawString("抵抗", canvas_damp_.width() / 2, canvas_damp_.height() / 2 - 20);
     canvas_damp_.drawString(buff, canvas_damp_.width() / 2, canvas_damp_.height() / 2 + 20);
-    canvas_damp_.pushSprite(&display_, 70, 70);
+    if (!is_suspended_) {
+        canvas_damp_.pushSprite(&display_, 70, 70);
+    }
+}
+
+// 抵抗表示の下に定位置停止の推奨ノッチと目標までの進み具合を出す
+void Display::drawTargetStop(bool is_visible, bool is_apply, int8_t notch, uint8_t progress) {
+    char buff[24];
+
+    if (!is_visible && !is_assist_visible_) return;
+    is_assist_visible_ = is_visible;
+
+    canvas_assist_.clear();
+    if (is_visible) {
+        if (notch == NOTCH_EMERGENCY) snprintf(buff, sizeof(buff), "%s EB %d%%", is_apply ? "自動" : "案内", progress);
+        else if (notch < 0) snprintf(buff, sizeof(buff), "%s B%d %d%%", is_apply ? "自動" : "案内", -notch, progress);
+        else snprintf(buff, sizeof(buff), "%s -- %d%%", is_apply ? "自動" : "案内", progress);
+        canvas_assist_.setTextColor(notch < 0 ? YELLOW : WHITE);
+        canvas_assist_.drawString(buff, canvas_assist_.width() / 2, canvas_assist_.height() / 2);
+    }
+    if (!is_suspended_) {
+        canvas_assist_.pushSprite(&display_, 70, 160);
+    }
+}
+
+void Display::addChartSample(int8_t speed, int8_t notch, uint8_t damp) {
+    chart_.addSample(speed, notch, damp);
+}
+
+void Display::setChartVisible(bool is_visible) {
+    if (is_visible == is_chart_visible_) return;
+    is_chart_visible_ = is_visible;
+    if (is_suspended_) return;
+
+    if (is_chart_visible_) {
+        chart_.redraw();
+        chart_.push(&display_, 0, display_.height() - PANEL_HEIGHT);
+    } else {
+        canvas_rail_.pushSprite(&display_, 0, display_.height() - canvas_rail_.height());
+    }
+}
+
+bool Display::is_chart_visible() {
+    return is_chart_visible_;
 }
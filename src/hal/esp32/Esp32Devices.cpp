@@ -0,0 +1,178 @@
+#include <Arduino.h>
+#include <M5Module4EncoderMotor.h>
+#include <usbhid.h>
+#include <hiduniversal.h>
+#include <usbhub.h>
+#include <usbh_midi.h>
+#include "hal/Hal.h"
+#include "display.h"
+
+class Esp32MotorPort : public hal::MotorPort {
+public:
+    virtual bool begin() {
+        return driver_.begin(&Wire, MODULE_4ENCODERMOTOR_ADDR, 21, 22);
+    }
+
+    virtual bool getFirmwareVersion(uint8_t *version) {
+        return driver_.getFirmwareVersion(version);
+    }
+
+    virtual uint8_t getAddress() {
+        return driver_.getI2CAddress();
+    }
+
+    virtual bool setNormalMode(uint8_t channel) {
+        return driver_.setMode(channel, NORMAL_MODE);
+    }
+
+    virtual bool setMotorSpeed(uint8_t channel, int8_t duty) {
+        return driver_.setMotorSpeed(channel, duty);
+    }
+
+    virtual bool readCurrent(uint16_t *milliamps) {
+        float amps = driver_.getMotorCurrent();
+        if (amps < 0) return false;
+        *milliamps = (uint16_t)(amps * 1000);
+        return true;
+    }
+
+private:
+    M5Module4EncoderMotor driver_;
+};
+
+// HIDとMIDIは同じUSBホストを共有する
+static USB usb;
+static USBHub hub(&usb);
+
+class HidReportForwarder : public HIDReportParser {
+public:
+    HidReportForwarder(): handler_(NULL) {}
+
+    void setHandler(hal::HidReportHandler_t handler) {
+        handler_ = handler;
+    }
+
+    virtual void Parse(USBHID *hid, bool is_rpt_id, uint8_t len, uint8_t *buf) {
+        if (handler_) handler_(len, buf);
+    }
+
+private:
+    hal::HidReportHandler_t handler_;
+};
+
+class Esp32HidSource : public hal::HidSource {
+public:
+    Esp32HidSource(): hid_(&usb) {}
+
+    virtual bool begin(hal::HidReportHandler_t handler) {
+        bool is_ok = true;
+
+        if (usb.Init() == -1)
+        {
+            hal::log("OSC did not start.\n");
+            is_ok = false;
+        }
+
+        forwarder_.setHandler(handler);
+        if (!hid_.SetReportParser(0, &forwarder_))
+        {
+            ErrorMessage<uint8_t>(PSTR("SetReportParser"), 1);
+            is_ok = false;
+        }
+
+        return is_ok;
+    }
+
+    virtual void poll() {
+        usb.Task();
+    }
+
+private:
+    HIDUniversal hid_;
+    HidReportForwarder forwarder_;
+};
+
+static bool is_midi_connected = false;
+
+static void onMidiInit() {
+    is_midi_connected = true;
+}
+
+class Esp32MidiSource : public hal::MidiSource {
+public:
+    Esp32MidiSource(): midi_(&usb) {}
+
+    virtual bool begin() {
+        is_midi_connected = false;
+        midi_.attachOnInit(onMidiInit);
+        return true;
+    }
+
+    virtual bool is_connected() {
+        return is_midi_connected;
+    }
+
+    virtual bool read(uint8_t *buffer, uint16_t *size) {
+        return midi_.RecvData(size, buffer) == 0;
+    }
+
+private:
+    USBH_MIDI midi_;
+};
+
+// ログと同じSerialに流すので、TELEMETRY_ENABLE を付けたビルドだけで有効にする
+class Esp32TelemetryPort : public hal::TelemetryPort {
+public:
+    virtual bool is_enabled() {
+#ifdef TELEMETRY_ENABLE
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    virtual size_t writable() {
+        int len = Serial.availableForWrite();
+        return len > 0 ? len : 0;
+    }
+
+    virtual size_t write(const uint8_t *data, size_t len) {
+        return Serial.write(data, len);
+    }
+};
+
+namespace hal {
+
+MotorPort &motorPort() {
+    static Esp32MotorPort port;
+    return port;
+}
+
+HidSource &hidSource() {
+    static Esp32HidSource source;
+    return source;
+}
+
+MidiSource &midiSource() {
+    static Esp32MidiSource source;
+    return source;
+}
+
+DisplaySurface &displaySurface() {
+    static Display display;
+    return display;
+}
+
+TelemetryPort &telemetryPort() {
+    static Esp32TelemetryPort port;
+    return port;
+}
+
+// 電源管理ICから読む電池電流 (USB給電中は充電電流が正で返る)
+bool readBatteryCurrent(int32_t *milliamps) {
+    if (M5.Power.getType() == m5::Power_Class::pmic_unknown) return false;
+    *milliamps = (int32_t)M5.Power.getBatteryCurrent();
+    return true;
+}
+
+}
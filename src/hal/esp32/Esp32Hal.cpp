@@ -0,0 +1,210 @@
+#include <Arduino.h>
+#include <stdarg.h>
+#include <string.h>
+#include <atomic>
+#include <esp_system.h>
+#include "freertos/timers.h"
+#include "freertos/semphr.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#ifdef CONFIG_PM_ENABLE
+#include <esp_pm.h>
+#endif
+#include "hal/Hal.h"
+
+#define RETAINED_MEMORY_SIZE        32
+#define LOG_BUFFER_SIZE             256
+#define LOG_LINE_SIZE               96      // キューの1要素 (長い行は分けて積む)
+#define LOG_QUEUE_DEPTH             16
+
+static const TickType_t TICK_PERIOD_TO_SEND_QUEUE = (10 / portTICK_RATE_MS);
+
+// 待機中のCPUクロック (APBを80MHzのまま保てる下限)
+static const uint32_t CPU_FREQ_POWER_SAVE_MHZ = 80;
+#ifdef CONFIG_PM_ENABLE
+static const uint32_t CPU_FREQ_SLEEP_MHZ = 40;
+#endif
+
+#ifdef TELEMETRY_ENABLE
+// テレメトリと同じSerialなので、ログはキューに積んでテレメトリのタスクにフレームとして送らせる
+// (どのタスクから呼んでもUARTを待たない。溢れた分は数えて後で知らせる)
+static StaticQueue_t log_queue_buffer;
+static uint8_t log_queue_storage[LOG_QUEUE_DEPTH * LOG_LINE_SIZE];
+static QueueHandle_t log_queue = xQueueCreateStatic(LOG_QUEUE_DEPTH, LOG_LINE_SIZE, log_queue_storage, &log_queue_buffer);
+static std::atomic<uint32_t> log_dropped(0);
+#endif
+
+// リセット後も保持される領域 (電源投入時は不定なので利用側で検証する)
+RTC_NOINIT_ATTR static uint32_t retained_memory[RETAINED_MEMORY_SIZE / sizeof(uint32_t)];
+
+typedef struct {
+    hal::TaskProc_t proc;
+    void *param;
+} TaskStart_t;
+
+namespace hal {
+
+uint32_t millis() {
+    return ::millis();
+}
+
+uint32_t micros() {
+    return ::micros();
+}
+
+void delayMs(uint32_t ms) {
+    ::delay(ms);
+}
+
+void log(const char *format, ...) {
+    char buff[LOG_BUFFER_SIZE];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(buff, sizeof(buff), format, args);
+    va_end(args);
+#ifdef TELEMETRY_ENABLE
+    char line[LOG_LINE_SIZE];
+    size_t len = strlen(buff);
+    for (size_t pos = 0; pos < len; pos += LOG_LINE_SIZE - 1) {
+        strncpy(line, &buff[pos], LOG_LINE_SIZE - 1);
+        line[LOG_LINE_SIZE - 1] = '\0';
+        if (xQueueSend(log_queue, line, 0) != pdTRUE) log_dropped.fetch_add(1);
+    }
+#else
+    Serial.print(buff);
+#endif
+}
+
+size_t readLog(char *line, size_t size) {
+#ifdef TELEMETRY_ENABLE
+    char item[LOG_LINE_SIZE];
+    uint32_t dropped = log_dropped.exchange(0);
+    if (dropped > 0) {
+        snprintf(line, size, "log: %u lines dropped\n", dropped);
+        return strlen(line);
+    }
+
+    if (xQueueReceive(log_queue, item, 0) != pdTRUE) return 0;
+    strncpy(line, item, size - 1);
+    line[size - 1] = '\0';
+    return strlen(line);
+#else
+    return 0;
+#endif
+}
+
+static void taskStartProc(void *param) {
+    TaskStart_t *start = (TaskStart_t *)param;
+    start->proc(start->param);
+    delete start;
+    vTaskDelete(NULL);
+}
+
+bool startTask(const char *name, TaskProc_t proc, void *param, uint8_t priority, uint32_t stack_size) {
+    TaskStart_t *start = new TaskStart_t;
+    start->proc = proc;
+    start->param = param;
+    if (xTaskCreate(taskStartProc, name, stack_size, start, priority, NULL) != pdPASS) {
+        delete start;
+        return false;
+    }
+    return true;
+}
+
+Signal::Signal() {
+    handle_ = xSemaphoreCreateBinary();
+}
+
+void Signal::post() {
+    xSemaphoreGive((SemaphoreHandle_t)handle_);
+}
+
+bool Signal::wait(uint32_t timeout_ms) {
+    return xSemaphoreTake((SemaphoreHandle_t)handle_, timeout_ms / portTICK_RATE_MS) == pdTRUE;
+}
+
+PeriodicTask::PeriodicTask(const char *name, uint32_t period_ms, TaskProc_t proc, void *param, uint8_t priority, uint32_t stack_size):
+    name_(name),
+    period_ms_(period_ms),
+    proc_(proc),
+    param_(param),
+    priority_(priority),
+    stack_size_(stack_size),
+    is_running_(false),
+    timer_(NULL),
+    queue_(NULL),
+    task_(NULL) {
+
+}
+
+void PeriodicTask::timerProc(void *timer) {
+    PeriodicTask *self = (PeriodicTask *)pvTimerGetTimerID((TimerHandle_t)timer);
+    uint32_t v = 0;
+    xQueueSend((QueueHandle_t)self->queue_, &v, TICK_PERIOD_TO_SEND_QUEUE);
+}
+
+void PeriodicTask::taskProc(void *param) {
+    PeriodicTask *self = (PeriodicTask *)param;
+    uint32_t value;
+
+    // タイマーを止めている間は起床しない
+    while (true) {
+        if (xQueueReceive((QueueHandle_t)self->queue_, &value, portMAX_DELAY) != pdTRUE) continue;
+        self->proc_(self->param_);
+    }
+}
+
+bool PeriodicTask::start() {
+    if (task_ == NULL) {
+        queue_ = xQueueCreate(10, sizeof(uint32_t));
+        timer_ = xTimerCreate(name_, period_ms_ / portTICK_RATE_MS, pdTRUE, this, (TimerCallbackFunction_t)timerProc);
+        if (queue_ == NULL || timer_ == NULL) return false;
+        if (xTaskCreate(taskProc, name_, stack_size_, this, priority_, (TaskHandle_t *)&task_) != pdPASS) return false;
+    }
+
+    is_running_ = xTimerStart((TimerHandle_t)timer_, 10 / portTICK_RATE_MS) == pdPASS;
+    return is_running_;
+}
+
+void PeriodicTask::stop() {
+    if (timer_ == NULL) return;
+    xTimerStop((TimerHandle_t)timer_, 10 / portTICK_RATE_MS);
+    is_running_ = false;
+}
+
+void PeriodicTask::trigger() {
+    if (queue_ == NULL) return;
+    uint32_t v = 0;
+    xQueueSend((QueueHandle_t)queue_, &v, 0);
+}
+
+bool PeriodicTask::is_running() {
+    return is_running_;
+}
+
+bool isWarmReset() {
+    esp_reset_reason_t reason = esp_reset_reason();
+    return reason != ESP_RST_POWERON && reason != ESP_RST_UNKNOWN;
+}
+
+void *retainedMemory(size_t size) {
+    if (size > sizeof(retained_memory)) return NULL;
+    return retained_memory;
+}
+
+void setPowerSave(bool is_enabled) {
+    static uint32_t active_mhz = 0;
+    if (active_mhz == 0) active_mhz = getCpuFrequencyMhz();
+
+#ifdef CONFIG_PM_ENABLE
+    // tickless idle が有効なビルドでは、タスクが全部待っている間に自動でライトスリープする
+    esp_pm_config_esp32_t config;
+    config.max_freq_mhz = is_enabled ? CPU_FREQ_POWER_SAVE_MHZ : active_mhz;
+    config.min_freq_mhz = is_enabled ? CPU_FREQ_SLEEP_MHZ : active_mhz;
+    config.light_sleep_enable = is_enabled;
+    if (esp_pm_configure(&config) == ESP_OK) return;
+#endif
+    setCpuFrequencyMhz(is_enabled ? CPU_FREQ_POWER_SAVE_MHZ : active_mhz);
+}
+
+}
@@ -0,0 +1,208 @@
+#include <stdio.h>
+#include <stdarg.h>
+#include "hal/Hal.h"
+#include "hal/PosixHal.h"
+
+#define PERIODIC_TASK_MAX           8
+#define RETAINED_MEMORY_SIZE        32
+
+typedef struct {
+    hal::PeriodicTask *task;
+    hal::TaskProc_t proc;
+    void *param;
+    uint64_t period_us;
+    uint64_t next_due_us;
+    bool is_running;
+} PeriodicEntry_t;
+
+static uint64_t now_us_ = 0;
+static bool is_dispatching = false;
+static bool is_warm_reset_ = false;
+static bool is_log_enabled = true;
+static bool is_power_save = false;
+static uint64_t power_save_since_us = 0;
+static uint64_t power_save_total_us = 0;
+static PeriodicEntry_t entries[PERIODIC_TASK_MAX];
+static uint8_t entry_count = 0;
+static uint32_t retained_memory[RETAINED_MEMORY_SIZE / sizeof(uint32_t)];
+
+static PeriodicEntry_t *findEntry(hal::PeriodicTask *task) {
+    for (uint8_t i = 0; i < entry_count; i++) {
+        if (entries[i].task == task) return &entries[i];
+    }
+    return NULL;
+}
+
+namespace hal {
+namespace posix {
+
+uint64_t now_us() {
+    return now_us_;
+}
+
+void advance(uint64_t us) {
+    uint64_t target = now_us_ + us;
+
+    // 周期タスク内からの待ちは時刻だけ進める (ESP32では他タスクが走る区間)
+    if (is_dispatching) {
+        now_us_ = target;
+        return;
+    }
+
+    while (true) {
+        PeriodicEntry_t *next = NULL;
+        for (uint8_t i = 0; i < entry_count; i++) {
+            PeriodicEntry_t &entry = entries[i];
+            if (!entry.is_running || entry.next_due_us > target) continue;
+            if (next == NULL || entry.next_due_us < next->next_due_us) next = &entry;
+        }
+        if (next == NULL) break;
+
+        if (next->next_due_us > now_us_) now_us_ = next->next_due_us;
+        next->next_due_us += next->period_us;
+
+        is_dispatching = true;
+        next->proc(next->param);
+        is_dispatching = false;
+    }
+
+    if (target > now_us_) now_us_ = target;
+}
+
+void setWarmReset(bool is_warm_reset) {
+    is_warm_reset_ = is_warm_reset;
+}
+
+void setLogEnabled(bool is_enabled) {
+    is_log_enabled = is_enabled;
+}
+
+uint64_t powerSaveUs() {
+    return power_save_total_us + (is_power_save ? now_us_ - power_save_since_us : 0);
+}
+
+}
+
+uint32_t millis() {
+    return (uint32_t)(now_us_ / 1000);
+}
+
+uint32_t micros() {
+    return (uint32_t)now_us_;
+}
+
+void delayMs(uint32_t ms) {
+    posix::advance((uint64_t)ms * 1000);
+}
+
+void log(const char *format, ...) {
+    if (!is_log_enabled) return;
+
+    printf("[%10.3f] ", now_us_ / 1000000.0);
+    va_list args;
+    va_start(args, format);
+    vprintf(format, args);
+    va_end(args);
+}
+
+// ログは標準出力に直接出すので溜めない
+size_t readLog(char *line, size_t size) {
+    return 0;
+}
+
+// 単発タスクはその場で最後まで実行する
+bool startTask(const char *name, TaskProc_t proc, void *param, uint8_t priority, uint32_t stack_size) {
+    proc(param);
+    return true;
+}
+
+Signal::Signal(): handle_(NULL) {
+
+}
+
+void Signal::post() {
+    handle_ = (void *)1;
+}
+
+bool Signal::wait(uint32_t timeout_ms) {
+    if (handle_ == NULL) posix::advance((uint64_t)timeout_ms * 1000);
+
+    bool is_posted = handle_ != NULL;
+    handle_ = NULL;
+    return is_posted;
+}
+
+PeriodicTask::PeriodicTask(const char *name, uint32_t period_ms, TaskProc_t proc, void *param, uint8_t priority, uint32_t stack_size):
+    name_(name),
+    period_ms_(period_ms),
+    proc_(proc),
+    param_(param),
+    priority_(priority),
+    stack_size_(stack_size),
+    is_running_(false),
+    timer_(NULL),
+    queue_(NULL),
+    task_(NULL) {
+
+}
+
+void PeriodicTask::timerProc(void *timer) {
+}
+
+void PeriodicTask::taskProc(void *param) {
+}
+
+bool PeriodicTask::start() {
+    PeriodicEntry_t *entry = findEntry(this);
+    if (entry == NULL) {
+        if (entry_count >= PERIODIC_TASK_MAX) return false;
+        entry = &entries[entry_count++];
+        entry->task = this;
+        entry->proc = proc_;
+        entry->param = param_;
+        entry->period_us = (uint64_t)period_ms_ * 1000;
+    }
+
+    entry->next_due_us = now_us_ + entry->period_us;
+    entry->is_running = true;
+    is_running_ = true;
+    return true;
+}
+
+void PeriodicTask::stop() {
+    PeriodicEntry_t *entry = findEntry(this);
+    if (entry != NULL) entry->is_running = false;
+    is_running_ = false;
+}
+
+// その場で1回実行する (中からの待ちは時刻だけ進める)
+void PeriodicTask::trigger() {
+    bool is_nested = is_dispatching;
+    is_dispatching = true;
+    proc_(param_);
+    is_dispatching = is_nested;
+}
+
+bool PeriodicTask::is_running() {
+    return is_running_;
+}
+
+bool isWarmReset() {
+    return is_warm_reset_;
+}
+
+void *retainedMemory(size_t size) {
+    if (size > sizeof(retained_memory)) return NULL;
+    return retained_memory;
+}
+
+// 省電力にしていた時間だけ数える
+void setPowerSave(bool is_enabled) {
+    if (is_enabled == is_power_save) return;
+
+    if (is_enabled) power_save_since_us = now_us_;
+    else power_save_total_us += now_us_ - power_save_since_us;
+    is_power_save = is_enabled;
+}
+
+}
@@ -0,0 +1,221 @@
+// ボタン操作の判定に時刻つきのエッジ列を流す
+//
+//   pio test -e native_test
+#include <unity.h>
+#include "InputEngine.h"
+
+#define POLL_PERIOD_MS              10      // appLoop で poll() を呼ぶおおよその間隔
+#define ACTION_LOG_MAX              32
+
+enum {
+    ID_PRESS,
+    ID_HOLD,
+    ID_REPEAT,
+    ID_LEFT,
+    ID_RIGHT,
+};
+
+enum {
+    ACTION_PRESS,
+    ACTION_HOLD,
+    ACTION_REPEAT,
+    ACTION_LEFT,
+    ACTION_RIGHT,
+    ACTION_CHORD,
+};
+
+static const InputBinding_t BINDINGS[] = {
+    {INPUT_PRESS, 1 << ID_PRESS, ACTION_PRESS},
+    {INPUT_LONG_PRESS, 1 << ID_HOLD, ACTION_HOLD},
+    {INPUT_REPEAT, 1 << ID_REPEAT, ACTION_REPEAT},
+    {INPUT_PRESS, 1 << ID_LEFT, ACTION_LEFT},
+    {INPUT_PRESS, 1 << ID_RIGHT, ACTION_RIGHT},
+    {INPUT_CHORD, (1 << ID_LEFT) | (1 << ID_RIGHT), ACTION_CHORD},
+};
+
+// App.cpp と同じ値
+static const InputEngine::Config_t CONFIG = {
+    20,       // チャタリングの収束待ち (ms)
+    1000,     // 長押し (ms)
+    500,      // 最初のリピートまで (ms)
+    150,      // リピート間隔 (ms)
+    200,      // 和音とみなす押下のずれ (ms)
+};
+
+typedef struct {
+    uint32_t time_ms;
+    uint8_t id;
+    bool is_down;
+} Edge_t;
+
+static InputActionEvent_t actions[ACTION_LOG_MAX];
+static uint8_t action_num;
+static uint32_t now_ms;
+
+namespace event {
+template <>
+void publish<InputActionEvent_t>(const InputActionEvent_t &event) {
+    if (action_num < ACTION_LOG_MAX) actions[action_num] = event;
+    action_num++;
+}
+}
+
+// 記録したエッジを時刻順に渡しながら end_ms まで poll() を回す
+static void replay(InputEngine &engine, const Edge_t *edges, uint8_t num, uint32_t end_ms) {
+    uint8_t next = 0;
+
+    for (; now_ms <= end_ms; now_ms += POLL_PERIOD_MS) {
+        for (; next < num && edges[next].time_ms <= now_ms; next++) {
+            engine.edge(edges[next].id, edges[next].is_down, edges[next].time_ms);
+        }
+        engine.poll(now_ms);
+    }
+}
+
+static uint8_t countAction(uint8_t action) {
+    uint8_t count = 0;
+    for (uint8_t i = 0; i < action_num && i < ACTION_LOG_MAX; i++) {
+        if (actions[i].action == action) count++;
+    }
+    return count;
+}
+
+static void assertAction(uint8_t index, uint8_t action, uint32_t time_ms) {
+    TEST_ASSERT_TRUE(index < action_num);
+    TEST_ASSERT_EQUAL_UINT8(action, actions[index].action);
+    TEST_ASSERT_EQUAL_UINT32(time_ms, actions[index].time_ms);
+}
+
+void setUp(void) {
+    action_num = 0;
+    now_ms = 0;
+}
+
+void tearDown(void) {}
+
+// 押した時と離した時の跳ね返りは1回の押下にまとめる
+static void test_bounce_is_one_press(void) {
+    InputEngine engine(BINDINGS, sizeof(BINDINGS) / sizeof(BINDINGS[0]), CONFIG);
+    static const Edge_t EDGES[] = {
+        {100, ID_PRESS, true}, {103, ID_PRESS, false}, {106, ID_PRESS, true}, {110, ID_PRESS, false}, {114, ID_PRESS, true},
+        {300, ID_PRESS, false}, {302, ID_PRESS, true}, {305, ID_PRESS, false},
+    };
+
+    replay(engine, EDGES, sizeof(EDGES) / sizeof(EDGES[0]), 400);
+
+    TEST_ASSERT_EQUAL_UINT8(1, action_num);
+    assertAction(0, ACTION_PRESS, 100);
+    TEST_ASSERT_EQUAL_UINT16(0, engine.pressed());
+}
+
+// 収束待ちの間に離れたままになったら、収束後に離したことにして次の押下を受ける
+static void test_glitch_release_settles_up(void) {
+    InputEngine engine(BINDINGS, sizeof(BINDINGS) / sizeof(BINDINGS[0]), CONFIG);
+    static const Edge_t EDGES[] = {
+        {100, ID_PRESS, true}, {105, ID_PRESS, false},
+        {200, ID_PRESS, true}, {260, ID_PRESS, false},
+    };
+
+    replay(engine, EDGES, 2, 150);
+    TEST_ASSERT_EQUAL_UINT16(0, engine.pressed());
+
+    replay(engine, EDGES + 2, 2, 300);
+    TEST_ASSERT_EQUAL_UINT8(2, action_num);
+    assertAction(0, ACTION_PRESS, 100);
+    assertAction(1, ACTION_PRESS, 200);
+}
+
+// 長押しはしきい値ちょうどで1回だけ、手前(5ms前)で離せば出ない
+static void test_long_press_threshold(void) {
+    InputEngine engine(BINDINGS, sizeof(BINDINGS) / sizeof(BINDINGS[0]), CONFIG);
+    static const Edge_t SHORT_EDGES[] = {{100, ID_HOLD, true}, {1095, ID_HOLD, false}};
+    static const Edge_t LONG_EDGES[] = {{2000, ID_HOLD, true}, {4000, ID_HOLD, false}};
+
+    replay(engine, SHORT_EDGES, 2, 1500);
+    TEST_ASSERT_EQUAL_UINT8(0, action_num);
+
+    replay(engine, LONG_EDGES, 1, 2000 + CONFIG.hold_ms - POLL_PERIOD_MS);
+    TEST_ASSERT_EQUAL_UINT8(0, action_num);
+
+    replay(engine, LONG_EDGES, 2, 4500);
+    TEST_ASSERT_EQUAL_UINT8(1, action_num);
+    assertAction(0, ACTION_HOLD, 2000 + CONFIG.hold_ms);
+}
+
+// 押した時、repeat_delay_ms 後、以降 repeat_ms 毎。離したら止まる
+static void test_repeat_cadence(void) {
+    InputEngine engine(BINDINGS, sizeof(BINDINGS) / sizeof(BINDINGS[0]), CONFIG);
+    static const Edge_t EDGES[] = {{100, ID_REPEAT, true}, {1000, ID_REPEAT, false}};
+    static const uint32_t EXPECTED_MS[] = {100, 600, 750, 900};
+
+    replay(engine, EDGES, 2, 2000);
+
+    TEST_ASSERT_EQUAL_UINT8(sizeof(EXPECTED_MS) / sizeof(EXPECTED_MS[0]), action_num);
+    for (uint8_t i = 0; i < sizeof(EXPECTED_MS) / sizeof(EXPECTED_MS[0]); i++) {
+        assertAction(i, ACTION_REPEAT, EXPECTED_MS[i]);
+    }
+}
+
+// 和音のボタンは単独の押下も出し、間隔ちょうど(200ms)で揃っても和音を1回だけ出す
+static void test_chord_within_window(void) {
+    InputEngine engine(BINDINGS, sizeof(BINDINGS) / sizeof(BINDINGS[0]), CONFIG);
+    static const Edge_t EDGES[] = {
+        {100, ID_LEFT, true}, {300, ID_RIGHT, true},
+        {1500, ID_LEFT, false}, {1500, ID_RIGHT, false},
+    };
+
+    replay(engine, EDGES, sizeof(EDGES) / sizeof(EDGES[0]), 2000);
+
+    TEST_ASSERT_EQUAL_UINT8(3, action_num);
+    assertAction(0, ACTION_LEFT, 100);
+    assertAction(1, ACTION_RIGHT, 300);
+    assertAction(2, ACTION_CHORD, 300);
+}
+
+// 押下のずれが和音の間隔を超えたら単独の押下だけ
+static void test_chord_outside_window_is_singles(void) {
+    InputEngine engine(BINDINGS, sizeof(BINDINGS) / sizeof(BINDINGS[0]), CONFIG);
+    static const Edge_t EDGES[] = {
+        {100, ID_LEFT, true}, {301, ID_RIGHT, true},
+        {1500, ID_LEFT, false}, {1500, ID_RIGHT, false},
+    };
+
+    replay(engine, EDGES, sizeof(EDGES) / sizeof(EDGES[0]), 2000);
+
+    TEST_ASSERT_EQUAL_UINT8(2, action_num);
+    TEST_ASSERT_EQUAL_UINT8(0, countAction(ACTION_CHORD));
+    TEST_ASSERT_EQUAL_UINT8(1, countAction(ACTION_LEFT));
+    TEST_ASSERT_EQUAL_UINT8(1, countAction(ACTION_RIGHT));
+}
+
+// 片方を離して押し直せば和音をもう一度出す
+static void test_chord_rearms_after_release(void) {
+    InputEngine engine(BINDINGS, sizeof(BINDINGS) / sizeof(BINDINGS[0]), CONFIG);
+    static const Edge_t EDGES[] = {
+        {100, ID_LEFT, true}, {150, ID_RIGHT, true},
+        {500, ID_RIGHT, false}, {600, ID_RIGHT, true},      // 左を押したまま: 左の押下から時間が経っている
+        {1000, ID_LEFT, false}, {1000, ID_RIGHT, false},
+        {1200, ID_RIGHT, true}, {1250, ID_LEFT, true},
+        {1500, ID_LEFT, false}, {1500, ID_RIGHT, false},
+    };
+
+    replay(engine, EDGES, sizeof(EDGES) / sizeof(EDGES[0]), 2000);
+
+    TEST_ASSERT_EQUAL_UINT8(2, countAction(ACTION_CHORD));
+    TEST_ASSERT_EQUAL_UINT8(2, countAction(ACTION_LEFT));
+    TEST_ASSERT_EQUAL_UINT8(3, countAction(ACTION_RIGHT));
+    assertAction(action_num - 1, ACTION_CHORD, 1250);
+    TEST_ASSERT_EQUAL_UINT16(0, engine.pressed());
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_bounce_is_one_press);
+    RUN_TEST(test_glitch_release_settles_up);
+    RUN_TEST(test_long_press_threshold);
+    RUN_TEST(test_repeat_cadence);
+    RUN_TEST(test_chord_within_window);
+    RUN_TEST(test_chord_outside_window_is_singles);
+    RUN_TEST(test_chord_rearms_after_release);
+    return UNITY_END();
+}
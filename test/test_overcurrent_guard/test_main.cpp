@@ -0,0 +1,172 @@
+// 過電流の判定に合成した電流波形を流す
+//
+//   pio test -e native_test
+#include <unity.h>
+#include "OvercurrentGuard.h"
+
+#define SAMPLE_PERIOD_MS            5       // App.cpp の電流監視の周期
+#define NORMAL_MA                   150
+#define SHORT_MA                    2000
+
+static const OvercurrentGuard::Config_t CONFIG = {
+  800,      // 閾値 (mA)
+  20,       // 検出時間 (ms)
+  1000,     // 安定とみなすまで (ms)
+  500,      // 最初の再通電までの待ち (ms)
+  4000,     // 待ちの上限 (ms)
+};
+
+typedef struct {
+    uint32_t cuts;
+    uint32_t restores;
+    uint32_t first_cut_ms;
+    uint32_t last_restore_ms;
+} TraceResult_t;
+
+static uint32_t now_ms;
+
+// 今の時刻から to_ms の直前まで一定の電流を流す
+static TraceResult_t run(OvercurrentGuard &guard, uint32_t to_ms, uint16_t current_ma) {
+    TraceResult_t result = {0, 0, 0, 0};
+
+    for (; now_ms < to_ms; now_ms += SAMPLE_PERIOD_MS) {
+        switch (guard.update(now_ms, current_ma)) {
+            case OvercurrentGuard::ACTION_CUT:
+                if (result.cuts++ == 0) result.first_cut_ms = now_ms;
+                break;
+            case OvercurrentGuard::ACTION_RESTORE:
+                result.restores++;
+                result.last_restore_ms = now_ms;
+                break;
+            default:
+                break;
+        }
+    }
+    return result;
+}
+
+// 短絡させて遮断し、最初の再通電まで進める
+static void tripAndRetry(OvercurrentGuard &guard) {
+    run(guard, now_ms + CONFIG.window_ms + SAMPLE_PERIOD_MS, SHORT_MA);
+    TEST_ASSERT_EQUAL(OvercurrentGuard::STATE_TRIPPED, guard.state());
+    run(guard, now_ms + guard.backoff_ms() + SAMPLE_PERIOD_MS, 0);
+    TEST_ASSERT_EQUAL(OvercurrentGuard::STATE_RETRY, guard.state());
+}
+
+void setUp(void) {
+    now_ms = 1000;
+}
+
+void tearDown(void) {}
+
+static void test_spike_shorter_than_window_does_not_trip(void) {
+    OvercurrentGuard guard(CONFIG);
+
+    run(guard, now_ms + 100, NORMAL_MA);
+    for (uint8_t i = 0; i < 10; i++) {
+        TraceResult_t spike = run(guard, now_ms + CONFIG.window_ms - SAMPLE_PERIOD_MS, SHORT_MA);
+        TraceResult_t rest = run(guard, now_ms + 50, NORMAL_MA);
+        TEST_ASSERT_EQUAL_UINT32(0, spike.cuts + rest.cuts);
+    }
+    TEST_ASSERT_EQUAL(OvercurrentGuard::STATE_NORMAL, guard.state());
+    TEST_ASSERT_EQUAL_UINT32(0, guard.trip_count());
+}
+
+static void test_sustained_overcurrent_trips_within_window(void) {
+    OvercurrentGuard guard(CONFIG);
+
+    run(guard, now_ms + 100, NORMAL_MA);
+    uint32_t start_ms = now_ms;
+    TraceResult_t result = run(guard, now_ms + 200, SHORT_MA);
+
+    TEST_ASSERT_EQUAL_UINT32(1, result.cuts);
+    TEST_ASSERT_TRUE(result.first_cut_ms - start_ms >= CONFIG.window_ms);
+    TEST_ASSERT_TRUE(result.first_cut_ms - start_ms <= (uint32_t)CONFIG.window_ms + SAMPLE_PERIOD_MS);
+    TEST_ASSERT_EQUAL(OvercurrentGuard::STATE_TRIPPED, guard.state());
+}
+
+static void test_backoff_doubles_up_to_cap(void) {
+    OvercurrentGuard guard(CONFIG);
+    static const uint32_t EXPECTED_MS[] = {500, 1000, 2000, 4000, 4000, 4000};
+
+    // 短絡したままなので再通電のたびに遮断し直す
+    uint32_t cut_ms = run(guard, now_ms + CONFIG.window_ms + SAMPLE_PERIOD_MS, SHORT_MA).first_cut_ms;
+    for (uint8_t i = 0; i < sizeof(EXPECTED_MS) / sizeof(EXPECTED_MS[0]); i++) {
+        TEST_ASSERT_EQUAL_UINT32(EXPECTED_MS[i], guard.backoff_ms());
+
+        TraceResult_t result = run(guard, now_ms + guard.backoff_ms() + CONFIG.window_ms + 2 * SAMPLE_PERIOD_MS, SHORT_MA);
+        TEST_ASSERT_EQUAL_UINT32(1, result.restores);
+        TEST_ASSERT_EQUAL_UINT32(1, result.cuts);
+        TEST_ASSERT_TRUE(result.last_restore_ms - cut_ms >= EXPECTED_MS[i]);
+        TEST_ASSERT_TRUE(result.last_restore_ms - cut_ms < EXPECTED_MS[i] + SAMPLE_PERIOD_MS);
+        cut_ms = result.first_cut_ms;
+    }
+    TEST_ASSERT_EQUAL_UINT32(7, guard.trip_count());
+}
+
+static void test_backoff_resets_after_stable_run(void) {
+    OvercurrentGuard guard(CONFIG);
+
+    // 2回遮断して待ちを延ばしてから、短絡が解消する
+    tripAndRetry(guard);
+    run(guard, now_ms + CONFIG.window_ms + SAMPLE_PERIOD_MS, SHORT_MA);
+    TEST_ASSERT_EQUAL_UINT32(1000, guard.backoff_ms());
+    run(guard, now_ms + guard.backoff_ms() + SAMPLE_PERIOD_MS, 0);
+    TEST_ASSERT_EQUAL(OvercurrentGuard::STATE_RETRY, guard.state());
+
+    // 安定時間に届く前はまだ延ばしたまま
+    run(guard, now_ms + CONFIG.stable_ms - 2 * SAMPLE_PERIOD_MS, NORMAL_MA);
+    TEST_ASSERT_EQUAL(OvercurrentGuard::STATE_RETRY, guard.state());
+    TEST_ASSERT_EQUAL_UINT32(1000, guard.backoff_ms());
+
+    run(guard, now_ms + 2 * SAMPLE_PERIOD_MS, NORMAL_MA);
+    TEST_ASSERT_EQUAL(OvercurrentGuard::STATE_NORMAL, guard.state());
+    TEST_ASSERT_EQUAL_UINT32(CONFIG.backoff_ms, guard.backoff_ms());
+}
+
+// 再通電直後の起動電流が検出時間より短ければ遮断しない
+static void test_short_inrush_on_retry_is_tolerated(void) {
+    OvercurrentGuard guard(CONFIG);
+
+    tripAndRetry(guard);
+    TraceResult_t inrush = run(guard, now_ms + CONFIG.window_ms - SAMPLE_PERIOD_MS, SHORT_MA);
+    TraceResult_t rest = run(guard, now_ms + CONFIG.stable_ms + SAMPLE_PERIOD_MS, NORMAL_MA);
+
+    TEST_ASSERT_EQUAL_UINT32(0, inrush.cuts + rest.cuts);
+    TEST_ASSERT_EQUAL(OvercurrentGuard::STATE_NORMAL, guard.state());
+}
+
+// 再通電中に検出時間を超えて流れ続けたら遮断し直し、待ちは延ばしたまま
+static void test_inrush_during_retry_retrips_without_reset(void) {
+    OvercurrentGuard guard(CONFIG);
+
+    tripAndRetry(guard);
+    run(guard, now_ms + 300, NORMAL_MA);
+    TEST_ASSERT_EQUAL(OvercurrentGuard::STATE_RETRY, guard.state());
+
+    TraceResult_t result = run(guard, now_ms + CONFIG.window_ms + SAMPLE_PERIOD_MS, SHORT_MA);
+    TEST_ASSERT_EQUAL_UINT32(1, result.cuts);
+    TEST_ASSERT_EQUAL(OvercurrentGuard::STATE_TRIPPED, guard.state());
+    TEST_ASSERT_EQUAL_UINT32(2 * CONFIG.backoff_ms, guard.backoff_ms());
+    TEST_ASSERT_EQUAL_UINT32(2, guard.trip_count());
+}
+
+static void test_zero_window_trips_on_first_sample(void) {
+    OvercurrentGuard::Config_t config = CONFIG;
+    config.window_ms = 0;
+    OvercurrentGuard guard(config);
+
+    TEST_ASSERT_EQUAL(OvercurrentGuard::ACTION_CUT, guard.update(now_ms, SHORT_MA));
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_spike_shorter_than_window_does_not_trip);
+    RUN_TEST(test_sustained_overcurrent_trips_within_window);
+    RUN_TEST(test_backoff_doubles_up_to_cap);
+    RUN_TEST(test_backoff_resets_after_stable_run);
+    RUN_TEST(test_short_inrush_on_retry_is_tolerated);
+    RUN_TEST(test_inrush_during_retry_retrips_without_reset);
+    RUN_TEST(test_zero_window_trips_on_first_sample);
+    return UNITY_END();
+}
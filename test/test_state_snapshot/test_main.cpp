@@ -0,0 +1,132 @@
+// RTCメモリのスナップショットの符号化・検証
+//
+//   pio test -e native_test
+#include <stddef.h>
+#include <unity.h>
+#include "StateSnapshot.h"
+#include "Crc16.h"
+
+static const ControllerState_t STATE = {true, false, 7};
+
+// 中身を書き換えた後にCRCだけ合わせ直す (CRC以外の検証で弾かれることを確かめる)
+static void resign(StateSnapshot_t *snapshot) {
+    snapshot->crc = crc16Ccitt((const uint8_t *)snapshot, offsetof(StateSnapshot_t, crc));
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_round_trip(void) {
+    static const ControllerState_t STATES[] = {
+        {false, false, 0}, {true, false, 3}, {false, true, 10}, {true, true, 5},
+    };
+
+    for (size_t i = 0; i < sizeof(STATES) / sizeof(STATES[0]); i++) {
+        StateSnapshot_t snapshot;
+        ControllerState_t state = {false, false, 0xFF};
+
+        StateSnapshot::encode(STATES[i], &snapshot);
+        TEST_ASSERT_TRUE(StateSnapshot::decode(snapshot, &state));
+        TEST_ASSERT_EQUAL(STATES[i].is_left, state.is_left);
+        TEST_ASSERT_EQUAL(STATES[i].is_evacute, state.is_evacute);
+        TEST_ASSERT_EQUAL_UINT8(STATES[i].decel_size, state.decel_size);
+    }
+}
+
+static void test_rejects_flipped_crc(void) {
+    StateSnapshot_t snapshot;
+    ControllerState_t state;
+
+    for (uint8_t bit = 0; bit < 16; bit++) {
+        StateSnapshot::encode(STATE, &snapshot);
+        snapshot.crc ^= 1 << bit;
+        TEST_ASSERT_FALSE(StateSnapshot::decode(snapshot, &state));
+    }
+}
+
+static void test_rejects_flipped_payload(void) {
+    StateSnapshot_t snapshot;
+    ControllerState_t state;
+
+    StateSnapshot::encode(STATE, &snapshot);
+    snapshot.decel_size ^= 0x01;
+    TEST_ASSERT_FALSE(StateSnapshot::decode(snapshot, &state));
+}
+
+static void test_rejects_bad_magic(void) {
+    StateSnapshot_t snapshot;
+    ControllerState_t state;
+
+    StateSnapshot::encode(STATE, &snapshot);
+    snapshot.magic = STATE_SNAPSHOT_MAGIC ^ 0x0100;
+    resign(&snapshot);
+    TEST_ASSERT_FALSE(StateSnapshot::decode(snapshot, &state));
+}
+
+static void test_rejects_bad_version(void) {
+    StateSnapshot_t snapshot;
+    ControllerState_t state;
+
+    StateSnapshot::encode(STATE, &snapshot);
+    snapshot.version = STATE_SNAPSHOT_VERSION + 1;
+    resign(&snapshot);
+    TEST_ASSERT_FALSE(StateSnapshot::decode(snapshot, &state));
+}
+
+static void test_rejects_out_of_range_decel_size(void) {
+    StateSnapshot_t snapshot;
+    ControllerState_t state;
+
+    StateSnapshot::encode(STATE, &snapshot);
+    snapshot.decel_size = 11;
+    resign(&snapshot);
+    TEST_ASSERT_FALSE(StateSnapshot::decode(snapshot, &state));
+}
+
+static void test_rejects_unknown_flags(void) {
+    StateSnapshot_t snapshot;
+    ControllerState_t state;
+
+    for (uint8_t bit = 2; bit < 8; bit++) {
+        StateSnapshot::encode(STATE, &snapshot);
+        snapshot.flags |= 1 << bit;
+        resign(&snapshot);
+        TEST_ASSERT_FALSE(StateSnapshot::decode(snapshot, &state));
+    }
+}
+
+static void test_rejects_invalidated(void) {
+    StateSnapshot_t snapshot;
+    ControllerState_t state;
+
+    StateSnapshot::encode(STATE, &snapshot);
+    StateSnapshot::invalidate(&snapshot);
+    TEST_ASSERT_FALSE(StateSnapshot::decode(snapshot, &state));
+}
+
+// 検証に失敗した時は復元先を書き換えない
+static void test_keeps_state_on_failure(void) {
+    StateSnapshot_t snapshot;
+    ControllerState_t state = {false, true, 2};
+
+    StateSnapshot::encode(STATE, &snapshot);
+    snapshot.crc ^= 0xFFFF;
+    TEST_ASSERT_FALSE(StateSnapshot::decode(snapshot, &state));
+    TEST_ASSERT_FALSE(state.is_left);
+    TEST_ASSERT_TRUE(state.is_evacute);
+    TEST_ASSERT_EQUAL_UINT8(2, state.decel_size);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_round_trip);
+    RUN_TEST(test_rejects_flipped_crc);
+    RUN_TEST(test_rejects_flipped_payload);
+    RUN_TEST(test_rejects_bad_magic);
+    RUN_TEST(test_rejects_bad_version);
+    RUN_TEST(test_rejects_out_of_range_decel_size);
+    RUN_TEST(test_rejects_unknown_flags);
+    RUN_TEST(test_rejects_invalidated);
+    RUN_TEST(test_keeps_state_on_failure);
+    return UNITY_END();
+}
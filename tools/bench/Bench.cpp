@@ -0,0 +1,36 @@
+#include "Bench.h"
+
+#ifdef ARDUINO
+#include <esp_cpu.h>
+#else
+#include <chrono>
+#endif
+
+volatile uint32_t bench_sink = 0;
+
+uint64_t benchNow() {
+#ifdef ARDUINO
+    return esp_cpu_get_cycle_count();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+void benchRun(const BenchCase_t &bench, uint8_t repeat, BenchResult_t *result) {
+    result->name = bench.name;
+    result->iterations = bench.iterations;
+    result->per_op = 0;
+
+    // 1回目はキャッシュを温めるだけで捨てる
+    bench.proc(bench.iterations);
+
+    for (uint8_t i = 0; i < repeat; i++) {
+        uint64_t start = benchNow();
+        bench.proc(bench.iterations);
+        // サイクルカウンタは32ビットで一周するので差分も32ビットで取る
+        uint32_t elapsed = (uint32_t)(benchNow() - start);
+
+        double per_op = (double)elapsed / bench.iterations;
+        if (i == 0 || per_op < result->per_op) result->per_op = per_op;
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef BENCH_H_
+#define BENCH_H_
+
+#include <stdint.h>
+#include "EventBus.h"
+
+// 計測の単位はホストではナノ秒、実機ではCPUサイクル
+#ifdef ARDUINO
+#define BENCH_UNIT                  "cycles"
+#else
+#define BENCH_UNIT                  "ns"
+#endif
+
+typedef void (*BenchProc_t)(uint32_t iterations);
+
+typedef struct {
+    const char *name;
+    BenchProc_t proc;
+    uint32_t iterations;
+} BenchCase_t;
+
+typedef struct {
+    const char *name;
+    uint32_t iterations;
+    double per_op;          // 繰り返しのうち最速の1回あたりの値
+} BenchResult_t;
+
+extern const BenchCase_t BENCH_CASES[];
+extern const uint8_t BENCH_CASE_NUM;
+
+// 最適化で計算が消えないように結果を書き込む先
+extern volatile uint32_t bench_sink;
+
+// 購読者3つに配る計測用のイベント (BenchEvents.cpp)
+typedef struct {
+    uint32_t value;
+} BenchEvent_t;
+
+namespace event {
+template <> void publish<BenchEvent_t>(const BenchEvent_t &event);
+}
+
+uint64_t benchNow();
+void benchRun(const BenchCase_t &bench, uint8_t repeat, BenchResult_t *result);
+
+#endif //BENCH_H_
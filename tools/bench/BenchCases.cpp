@@ -0,0 +1,290 @@
+// 制御経路の各処理を単体で繰り返す
+#include <stdio.h>
+#include <string.h>
+#include "Bench.h"
+#include "MasterController.h"
+#include "MidiDataReceiver.h"
+#include "InputEngine.h"
+#include "SpeedControl.h"
+#include "SpeedGauge.h"
+#include "TrainController.h"
+#include "TrainProtection.h"
+#include "SpeedLimitZones.h"
+#include "Telemetry.h"
+#include "DefaultNotchTable.h"
+
+#define HID_REPORT_SIZE             8
+#define MIDI_PACKET_NUM             16
+
+static const uint8_t HANDLE_STEPS[] = {
+    EmergencyBrake, Brake8, Brake4, Brake1, Center, Power1, Power3, Power5,
+};
+#define HANDLE_STEP_NUM             (sizeof(HANDLE_STEPS) / sizeof(HANDLE_STEPS[0]))
+
+// イベントバス導入前の1イベント1関数ポインタの呼び出し (比較用)
+typedef void (*HandleEvent_t)(HandleState_t state);
+
+static void onHandle(HandleState_t state) { bench_sink += state; }
+static void onHandle2(HandleState_t state) { bench_sink ^= state; }
+static void onHandle3(HandleState_t state) { bench_sink -= state >> 1; }
+
+// 最適化で直接呼び出しにならないようにvolatileで持つ
+static HandleEvent_t volatile handle_events[] = {onHandle, onHandle2, onHandle3};
+
+// 毎回ハンドル位置が変わるレポート
+static void benchParseChanged(uint32_t iterations) {
+    MasterControllerEvents events;
+    MasterController mascon(&events);
+    uint8_t report[HID_REPORT_SIZE] = {0, 0, None, 0, Center, 0, 0, 0};
+
+    for (uint32_t i = 0; i < iterations; i++) {
+        report[4] = HANDLE_STEPS[i % HANDLE_STEP_NUM];
+        mascon.Parse(HID_REPORT_SIZE, report, i);
+    }
+}
+
+// USBホストは変化がなくてもレポートを送ってくるので、こちらが大半を占める
+static void benchParseUnchanged(uint32_t iterations) {
+    MasterControllerEvents events;
+    MasterController mascon(&events);
+    uint8_t report[HID_REPORT_SIZE] = {0, 0, None, 0, Center, 0, 0, 0};
+
+    for (uint32_t i = 0; i < iterations; i++) {
+        mascon.Parse(HID_REPORT_SIZE, report, i);
+    }
+}
+
+static void benchGamePadChanged(uint32_t iterations) {
+    MasterControllerEvents events;
+    GamePadEventData data = {0, 0, None, 0, Center};
+
+    for (uint32_t i = 0; i < iterations; i++) {
+        data.X = (uint8_t)(i >> 3);
+        data.Y = (i & 0x04) ? Plus : 0;
+        data.Z1 = (i & 0x08) ? Right : None;
+        data.Rz = HANDLE_STEPS[i % HANDLE_STEP_NUM];
+        events.OnGamePadChanged(&data, i);
+    }
+}
+
+static void benchEventFnptr(uint32_t iterations) {
+    for (uint32_t i = 0; i < iterations; i++) {
+        HandleEvent_t handler = handle_events[0];
+        if (handler != NULL) handler((HandleState_t)HANDLE_STEPS[i % HANDLE_STEP_NUM]);
+    }
+}
+
+static void benchEventFnptr3(uint32_t iterations) {
+    for (uint32_t i = 0; i < iterations; i++) {
+        for (uint8_t j = 0; j < 3; j++) {
+            HandleEvent_t handler = handle_events[j];
+            if (handler != NULL) handler((HandleState_t)HANDLE_STEPS[i % HANDLE_STEP_NUM]);
+        }
+    }
+}
+
+static void benchEventBus(uint32_t iterations) {
+    for (uint32_t i = 0; i < iterations; i++) {
+        event::publish(HandleChangedEvent_t{(HandleState_t)HANDLE_STEPS[i % HANDLE_STEP_NUM]});
+    }
+}
+
+static void benchEventBus3(uint32_t iterations) {
+    for (uint32_t i = 0; i < iterations; i++) {
+        event::publish(BenchEvent_t{HANDLE_STEPS[i % HANDLE_STEP_NUM]});
+    }
+}
+
+// 押下・解放を交互に入れ、和音・リピート・長押しの判定も通す
+static void benchInputEdge(uint32_t iterations) {
+    static const InputBinding_t BINDINGS[] = {
+        {INPUT_PRESS, BUTTON_BIT(AButton), 0},
+        {INPUT_LONG_PRESS, BUTTON_BIT(YButton), 1},
+        {INPUT_CHORD, BUTTON_BIT(ZLButton) | BUTTON_BIT(ZRButton), 2},
+        {INPUT_REPEAT, ADDITIONAL_BUTTON_BIT(Plus), 3},
+    };
+    static const uint8_t IDS[] = {2, 0, 6, 7, 9};     // A, Y, ZL, ZR, Plus
+    static const InputEngine::Config_t CONFIG = {20, 1000, 500, 150, 200};
+    InputEngine engine(BINDINGS, sizeof(BINDINGS) / sizeof(BINDINGS[0]), CONFIG);
+    uint32_t time_ms = 0;
+
+    for (uint32_t i = 0; i < iterations; i++) {
+        time_ms += 30;
+        engine.edge(IDS[(i >> 1) % sizeof(IDS)], (i & 1) == 0, time_ms);
+        engine.poll(time_ms);
+    }
+}
+
+// PAD・コントロールチェンジ・鍵盤を混ぜた64バイトのパケット列を返し続ける
+class BenchMidiSource : public hal::MidiSource {
+public:
+    BenchMidiSource() {
+        static const uint8_t PACKETS[][4] = {
+            {0x09, 0x98, 0x30, 0x7F},   // PAD 非常停止
+            {0x09, 0x98, 0x32, 0x7F},   // PAD 方向切替
+            {0x0B, 0xB1, 0x14, 0x40},   // CC 加速量
+            {0x0B, 0xB1, 0x16, 0x10},   // CC 抵抗
+            {0x09, 0x91, 0x3C, 0x64},   // 鍵盤 ON
+            {0x08, 0x81, 0x3D, 0x00},   // 鍵盤 OFF
+            {0x09, 0x92, 0x40, 0x64},   // 対象外のチャンネル
+            {0x0B, 0xB1, 0x17, 0x55},   // CC 最高速度
+        };
+        for (uint8_t i = 0; i < MIDI_PACKET_NUM; i++) {
+            memcpy(&buffer_[i * 4], PACKETS[i % (sizeof(PACKETS) / sizeof(PACKETS[0]))], 4);
+        }
+    }
+
+    virtual bool begin() {
+        return true;
+    }
+
+    virtual bool is_connected() {
+        return true;
+    }
+
+    virtual bool read(uint8_t *buffer, uint16_t *size) {
+        memcpy(buffer, buffer_, sizeof(buffer_));
+        *size = sizeof(buffer_);
+        return true;
+    }
+
+private:
+    uint8_t buffer_[MIDI_PACKET_NUM * 4];
+};
+
+static void benchMidiDecode(uint32_t iterations) {
+    BenchMidiSource source;
+    MidiDataReceiver receiver(&source);
+
+    receiver.init();
+    for (uint32_t i = 0; i < iterations; i++) {
+        receiver.loop();
+    }
+}
+
+// 力行で加速 -> 惰行 -> ブレーキ -> 非常 を繰り返す
+static void benchSpeedTick(uint32_t iterations) {
+    static const int8_t NOTCHES[] = {5, 5, 3, 0, 0, -2, -6, NOTCH_EMERGENCY};
+    NotchTableStore tables(DEFAULT_NOTCH_TABLE);
+    SpeedControl control(&tables);
+
+    for (uint32_t i = 0; i < iterations; i++) {
+        control.tick(NOTCHES[(i >> 5) % sizeof(NOTCHES)], i & 0x07);
+        bench_sink += control.current_speed();
+    }
+}
+
+class BenchMotorPort : public hal::MotorPort {
+public:
+    virtual bool begin() { return true; }
+    virtual bool getFirmwareVersion(uint8_t *version) { *version = 1; return true; }
+    virtual uint8_t getAddress() { return 0x24; }
+    virtual bool setNormalMode(uint8_t channel) { return true; }
+    virtual bool setMotorSpeed(uint8_t channel, int8_t duty) { bench_sink += duty; return true; }
+    virtual bool readCurrent(uint16_t *milliamps) { *milliamps = 0; return true; }
+};
+
+static void benchTrainClamp(uint32_t iterations) {
+    BenchMotorPort port;
+    TrainController controller(&port);
+
+    controller.begin(0, false);
+    for (uint32_t i = 0; i < iterations; i++) {
+        int8_t step = (int8_t)(i & 0x3F);
+        if (i & 0x40) controller.brakeSpeed(step);
+        else controller.accelSpeed(step);
+        controller.setSpeed((int8_t)(i * 7));
+    }
+}
+
+static void benchGaugeGeometry(uint32_t iterations) {
+    SpeedGauge gauge;
+    SpeedGauge::Arc_t arc;
+
+    gauge.setMaxSpeed(85);
+    for (uint32_t i = 0; i < iterations; i++) {
+        gauge.setSpeed((int8_t)(i % 140) - 5);
+        if (gauge.nextArc(&arc)) bench_sink += (uint32_t)arc.end_deg;
+    }
+}
+
+// 加減速を繰り返して制限区間とブレーキ曲線を通過させる
+static void benchProtectionTick(uint32_t iterations) {
+    NotchTableStore tables(DEFAULT_NOTCH_TABLE);
+    SpeedLimitIndex zones(POSITION_ZONES, sizeof(POSITION_ZONES) / sizeof(POSITION_ZONES[0]), SPEED_LIMIT_LAP_LENGTH);
+    TrainProtection protection(&tables, &zones, NULL);
+
+    protection.setEnabled(true);
+    protection.setMaxSpeed(85);
+    for (uint32_t i = 0; i < iterations; i++) {
+        int8_t speed = (int8_t)(i % 170 < 85 ? i % 170 : 170 - i % 170);
+        bench_sink += protection.tick(speed, i * 50);
+    }
+}
+
+// UARTの代わりに書かれたバイトを捨てる (いつでも書ける)
+class BenchTelemetryPort : public hal::TelemetryPort {
+public:
+    virtual bool is_enabled() { return true; }
+    virtual size_t writable() { return 128; }
+    virtual size_t write(const uint8_t *data, size_t len) { bench_sink += data[len - 1] + len; return len; }
+};
+
+static TelemetryTick_t benchTelemetryRecord(uint32_t i) {
+    TelemetryTick_t record = {};
+    record.time_ms = i * 50;
+    record.speed = (int8_t)(i % 85);
+    record.target = 70;
+    record.allowed = 85;
+    record.handle_notch = (int8_t)(i % 5);
+    record.notch = (int8_t)(i % 5);
+    record.resistance = i & 0x07;
+    record.current_ma = 120 + (i & 0x3F);
+    record.i2c_us = 300 + (i & 0x7F);
+    record.jitter_us = (int16_t)(i & 0xFF) - 128;
+    return record;
+}
+
+// 1ティック分の記録を積んで、フレームにして送るまで
+static void benchTelemetryFrame(uint32_t iterations) {
+    BenchTelemetryPort port;
+    Telemetry telemetry(&port);
+
+    for (uint32_t i = 0; i < iterations; i++) {
+        telemetry.push(benchTelemetryRecord(i));
+        telemetry.drain();
+    }
+}
+
+// 同じ項目をテキストの1行にする場合 (比較用)
+static void benchTelemetryPrintf(uint32_t iterations) {
+    char line[96];
+
+    for (uint32_t i = 0; i < iterations; i++) {
+        TelemetryTick_t r = benchTelemetryRecord(i);
+        int len = snprintf(line, sizeof(line), "%u,%u,%d,%d,%d,%d,%d,%u,%u,%u,%u,%d\n",
+                           r.time_ms, r.seq, r.speed, r.target, r.allowed, r.handle_notch, r.notch,
+                           r.resistance, r.flags, r.current_ma, r.i2c_us, r.jitter_us);
+        bench_sink += line[len - 2] + len;
+    }
+}
+
+const BenchCase_t BENCH_CASES[] = {
+    {"mascon_parse_changed", benchParseChanged, 100000},
+    {"mascon_parse_unchanged", benchParseUnchanged, 100000},
+    {"gamepad_changed", benchGamePadChanged, 100000},
+    {"midi_decode_64b", benchMidiDecode, 20000},
+    {"event_fnptr", benchEventFnptr, 100000},
+    {"event_fnptr_3", benchEventFnptr3, 100000},
+    {"event_bus", benchEventBus, 100000},
+    {"event_bus_3", benchEventBus3, 100000},
+    {"input_edge", benchInputEdge, 100000},
+    {"speed_tick", benchSpeedTick, 100000},
+    {"train_clamp", benchTrainClamp, 100000},
+    {"gauge_geometry", benchGaugeGeometry, 100000},
+    {"atp_tick", benchProtectionTick, 100000},
+    {"telemetry_frame", benchTelemetryFrame, 100000},
+    {"telemetry_printf", benchTelemetryPrintf, 100000},
+};
+
+const uint8_t BENCH_CASE_NUM = sizeof(BENCH_CASES) / sizeof(BENCH_CASES[0]);
@@ -0,0 +1,63 @@
+// 計測用のイベント購読者
+// アプリと同じく発行側とは別の翻訳単位で publish<E>() を特殊化する
+#include "Bench.h"
+#include "MasterController.h"
+#include "MidiDataReceiver.h"
+#include "InputEngine.h"
+
+template <typename E>
+static void sinkEvent(const E &event) {
+    bench_sink += sizeof(event);
+}
+
+static void sinkHandle(const HandleChangedEvent_t &event) { bench_sink += event.state; }
+static void sinkHat(const HatChangedEvent_t &event) { bench_sink += event.state; }
+static void sinkButton(const ButtonEdgeEvent_t &event) { bench_sink += event.id + event.is_down; }
+static void sinkAction(const InputActionEvent_t &event) { bench_sink += event.action; }
+static void sinkFanout1(const BenchEvent_t &event) { bench_sink += event.value; }
+static void sinkFanout2(const BenchEvent_t &event) { bench_sink ^= event.value; }
+static void sinkFanout3(const BenchEvent_t &event) { bench_sink -= event.value >> 1; }
+
+namespace event {
+
+template <>
+void publish<HandleChangedEvent_t>(const HandleChangedEvent_t &event) {
+    SubscriberList<HandleChangedEvent_t, sinkHandle>::dispatch(event);
+}
+
+template <>
+void publish<HatChangedEvent_t>(const HatChangedEvent_t &event) {
+    SubscriberList<HatChangedEvent_t, sinkHat>::dispatch(event);
+}
+
+template <>
+void publish<ButtonEdgeEvent_t>(const ButtonEdgeEvent_t &event) {
+    SubscriberList<ButtonEdgeEvent_t, sinkButton>::dispatch(event);
+}
+
+template <>
+void publish<InputActionEvent_t>(const InputActionEvent_t &event) {
+    SubscriberList<InputActionEvent_t, sinkAction>::dispatch(event);
+}
+
+template <>
+void publish<MidiPadEvent_t>(const MidiPadEvent_t &event) {
+    SubscriberList<MidiPadEvent_t, sinkEvent<MidiPadEvent_t> >::dispatch(event);
+}
+
+template <>
+void publish<MidiKeyEvent_t>(const MidiKeyEvent_t &event) {
+    SubscriberList<MidiKeyEvent_t, sinkEvent<MidiKeyEvent_t> >::dispatch(event);
+}
+
+template <>
+void publish<MidiControlEvent_t>(const MidiControlEvent_t &event) {
+    SubscriberList<MidiControlEvent_t, sinkEvent<MidiControlEvent_t> >::dispatch(event);
+}
+
+template <>
+void publish<BenchEvent_t>(const BenchEvent_t &event) {
+    SubscriberList<BenchEvent_t, sinkFanout1, sinkFanout2, sinkFanout3>::dispatch(event);
+}
+
+}
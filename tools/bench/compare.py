@@ -0,0 +1,59 @@
+#!/usr/bin/env python3
+"""ベンチマーク結果(CSV)を基準値と比較する。
+
+    python3 tools/bench/compare.py baseline.csv result.csv [--threshold 20]
+
+閾値(%)を超えて遅くなった項目があれば終了コード1を返す。
+実機の結果はシリアル出力をそのまま保存したもの('#'で始まる行は無視)を渡す。
+"""
+import argparse
+import csv
+import sys
+
+
+def load(path):
+    with open(path, newline='') as fp:
+        rows = [line for line in fp if line.strip() and not line.startswith('#')]
+    return {row['name']: row for row in csv.DictReader(rows)}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('baseline')
+    parser.add_argument('result')
+    parser.add_argument('--threshold', type=float, default=20.0, help='許容する悪化率 (%%)')
+    args = parser.parse_args()
+
+    baseline = load(args.baseline)
+    result = load(args.result)
+    regressions = 0
+
+    print(f"{'name':<26} {'baseline':>10} {'result':>10} {'delta':>8}  unit")
+    for name, row in result.items():
+        value = float(row['per_op'])
+        base = baseline.get(name)
+        if base is None:
+            print(f"{name:<26} {'-':>10} {value:>10.2f} {'new':>8}  {row['unit']}")
+            continue
+        if base['unit'] != row['unit']:
+            print(f"{name:<26} unit mismatch: {base['unit']} / {row['unit']}")
+            regressions += 1
+            continue
+
+        base_value = float(base['per_op'])
+        delta = (value - base_value) / base_value * 100 if base_value > 0 else 0.0
+        mark = ''
+        if delta > args.threshold:
+            mark = '  REGRESSION'
+            regressions += 1
+        print(f"{name:<26} {base_value:>10.2f} {value:>10.2f} {delta:>+7.1f}%  {row['unit']}{mark}")
+
+    for name in baseline:
+        if name not in result:
+            print(f"{name:<26} missing from result")
+
+    return 1 if regressions else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,79 @@
+// 制御経路のマイクロベンチマーク
+//
+//   pio run -e bench_native && .pio/build/bench_native/program [-o result.csv] [-r repeat]
+//   pio run -e bench_core2 -t upload && pio device monitor   (シリアルに同じ形式で出力)
+//
+// 出力は "name,iterations,unit,per_op" のCSV。基準値との比較は
+//   python3 tools/bench/compare.py tools/bench/baseline_native.csv result.csv
+// で行い、閾値を超えて遅くなった項目があれば終了コード1を返す。
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "Bench.h"
+
+#define BENCH_REPEAT                9
+
+#ifdef ARDUINO
+#include <Arduino.h>
+
+void setup() {
+    Serial.begin(115200);
+    delay(1000);
+
+    // 計測中にタスク切替が入らないよう、ループタスクの優先度を上げておく
+    vTaskPrioritySet(NULL, configMAX_PRIORITIES - 1);
+    Serial.printf("# cpu %u MHz\n", getCpuFrequencyMhz());
+    for (uint8_t i = 0; i < BENCH_CASE_NUM; i++) {
+        BenchResult_t result;
+        if (i == 0) Serial.println("name,iterations,unit,per_op");
+        benchRun(BENCH_CASES[i], BENCH_REPEAT, &result);
+        Serial.printf("%s,%u,%s,%.2f\n", result.name, result.iterations, BENCH_UNIT, result.per_op);
+    }
+    Serial.println("# done");
+    Serial.printf("# sink %u\n", bench_sink);
+}
+
+void loop() {
+    delay(1000);
+}
+#else
+#include "hal/PosixHal.h"
+
+static void writeResults(FILE *fp, uint8_t repeat) {
+    fprintf(fp, "name,iterations,unit,per_op\n");
+    for (uint8_t i = 0; i < BENCH_CASE_NUM; i++) {
+        BenchResult_t result;
+        benchRun(BENCH_CASES[i], repeat, &result);
+        fprintf(fp, "%s,%u,%s,%.2f\n", result.name, result.iterations, BENCH_UNIT, result.per_op);
+        fflush(fp);
+    }
+}
+
+int main(int argc, char **argv) {
+    const char *out_path = NULL;
+    int repeat = BENCH_REPEAT;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) out_path = argv[++i];
+        else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) repeat = atoi(argv[++i]);
+    }
+    if (repeat < 1) repeat = 1;
+
+    // TrainController::begin()のログをCSVに混ぜない
+    hal::posix::setLogEnabled(false);
+
+    FILE *fp = stdout;
+    if (out_path != NULL) {
+        fp = fopen(out_path, "w");
+        if (fp == NULL) {
+            fprintf(stderr, "failed to write: %s\n", out_path);
+            return 1;
+        }
+    }
+    writeResults(fp, repeat);
+    if (fp != stdout) fclose(fp);
+
+    fprintf(stderr, "sink %u\n", bench_sink);
+    return 0;
+}
+#endif
@@ -0,0 +1,375 @@
+// 目標の加速・減速カーブに合うノッチテーブルを総当たりで探す
+//
+//   pio run -e notch_tuner
+//   .pio/build/notch_tuner/program [targets.txt] [-o include/DefaultNotchTable.h] [-j threads]
+//   .pio/build/notch_tuner/program --current -o include/DefaultNotchTable.h  (現在値のまま書き直す)
+//
+// 目標は1行1キーフレーム "<ノッチ> <時刻ms> <速度>" (tools/notch_tuner/targets.txt を参照)。
+// ノッチは P1-P5 / B1-B8 / EB / R1-R10 (R は中立で環境抵抗を掛けた惰行)。
+// カーブは最初のキーフレームの速度から始め、ティック毎の速度と目標の二乗平均誤差で評価する。
+//
+// 各ノッチの速度変化はそのノッチの設定値だけで決まるので、ノッチ毎に
+// NotchEditorと同じ設定範囲を全て試し、全コアに分割して評価する。
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include "SpeedControl.h"
+#include "DefaultNotchTable.h"
+
+#define TICK_PERIOD_MS              50
+#define CHUNK_CANDIDATES            4096
+#define EOL                         "\r\n"    // 出力はリポジトリのソースと同じCRLF
+
+// 探索範囲 (NotchEditorの設定範囲と同じ)
+#define POWER_MAX_SPEED_MAX         127
+#define POWER_ACCEL_MAX             50
+#define POWER_PERIOD_MAX            30
+#define BRAKE_PERIOD_MAX            30
+#define BRAKE_DECEL_MAX             127
+#define RESISTANCE_DECEL_MAX        10
+#define RESISTANCE_PERIOD_MAX       60
+
+typedef enum {
+    KIND_POWER,
+    KIND_BRAKE,
+    KIND_RESISTANCE,
+} TargetKind_t;
+
+typedef struct {
+    uint32_t time_ms;
+    int speed;
+} Keyframe_t;
+
+typedef struct {
+    std::string name;
+    TargetKind_t kind;
+    uint8_t index;          // power[] / brake[] / resistance[] の添字
+    int8_t notch;
+    uint8_t resistance;
+    std::vector<Keyframe_t> frames;
+    uint32_t candidates;
+} Target_t;
+
+typedef struct {
+    double error;
+    uint32_t distance;      // 現在値からの変更量 (同じ誤差なら変更の少ない方を選ぶ)
+    uint32_t candidate;
+} Best_t;
+
+typedef struct {
+    size_t target;
+    uint32_t begin;
+    uint32_t end;
+} Chunk_t;
+
+static bool parseNotch(const char *name, Target_t *target) {
+    int n;
+
+    if (strcmp(name, "EB") == 0) {
+        target->kind = KIND_BRAKE;
+        target->index = BRAKE_NOTCH_NUM - 1;
+        target->notch = NOTCH_EMERGENCY;
+        target->resistance = 0;
+        return true;
+    }
+    if (sscanf(name, "P%d", &n) == 1 && n >= 1 && n <= POWER_NOTCH_NUM) {
+        target->kind = KIND_POWER;
+        target->index = n - 1;
+        target->notch = n;
+        target->resistance = 0;
+        return true;
+    }
+    if (sscanf(name, "B%d", &n) == 1 && n >= 1 && n < BRAKE_NOTCH_NUM) {
+        target->kind = KIND_BRAKE;
+        target->index = n - 1;
+        target->notch = -n;
+        target->resistance = 0;
+        return true;
+    }
+    if (sscanf(name, "R%d", &n) == 1 && n >= 1 && n < ENV_RESISTANCE_NUM) {
+        target->kind = KIND_RESISTANCE;
+        target->index = n;
+        target->notch = 0;
+        target->resistance = n;
+        return true;
+    }
+    return false;
+}
+
+static bool loadTargets(const char *path, std::vector<Target_t> &targets) {
+    FILE *fp = fopen(path, "r");
+    if (fp == NULL) return false;
+
+    char line[128];
+    bool is_ok = true;
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        char name[8];
+        Keyframe_t frame;
+
+        if (line[0] == '#') continue;
+        if (sscanf(line, "%7s %u %d", name, &frame.time_ms, &frame.speed) != 3) continue;
+
+        size_t i = 0;
+        while (i < targets.size() && targets[i].name != name) i++;
+        if (i == targets.size()) {
+            Target_t target;
+            if (!parseNotch(name, &target)) {
+                fprintf(stderr, "%s: unknown notch: %s\n", path, name);
+                is_ok = false;
+                continue;
+            }
+            target.name = name;
+            targets.push_back(target);
+        }
+        targets[i].frames.push_back(frame);
+    }
+
+    fclose(fp);
+    return is_ok && targets.size() > 0;
+}
+
+static uint32_t candidateCount(TargetKind_t kind) {
+    switch (kind) {
+        case KIND_POWER: return POWER_MAX_SPEED_MAX * POWER_ACCEL_MAX * POWER_PERIOD_MAX;
+        case KIND_BRAKE: return BRAKE_PERIOD_MAX * BRAKE_DECEL_MAX;
+        default: return RESISTANCE_DECEL_MAX * RESISTANCE_PERIOD_MAX;
+    }
+}
+
+static uint32_t diff(uint8_t a, uint8_t b) {
+    return a > b ? a - b : b - a;
+}
+
+// 候補番号を設定値に展開してテーブルに書き込み、元の値との差を返す
+static uint32_t applyCandidate(const Target_t &target, uint32_t candidate, NotchTable_t *table) {
+    if (target.kind == KIND_POWER) {
+        PowerNotchInfo_t &power = table->power[target.index];
+        PowerNotchInfo_t base = power;
+        power.max_speed = candidate % POWER_MAX_SPEED_MAX + 1;
+        candidate /= POWER_MAX_SPEED_MAX;
+        power.base_accel = candidate % POWER_ACCEL_MAX + 1;
+        power.period = candidate / POWER_ACCEL_MAX + 1;
+        return diff(power.max_speed, base.max_speed) + diff(power.base_accel, base.base_accel) + diff(power.period, base.period);
+    }
+
+    if (target.kind == KIND_BRAKE) {
+        BrakeNotchInfo_t &brake = table->brake[target.index];
+        BrakeNotchInfo_t base = brake;
+        brake.decel = candidate % BRAKE_DECEL_MAX + 1;
+        brake.period = candidate / BRAKE_DECEL_MAX + 1;
+        return diff(brake.decel, base.decel) + diff(brake.period, base.period);
+    }
+
+    EnvironmentResistance_t &resistance = table->resistance[target.index];
+    EnvironmentResistance_t base = resistance;
+    resistance.decel = candidate % RESISTANCE_DECEL_MAX + 1;
+    resistance.period = candidate / RESISTANCE_DECEL_MAX + 1;
+    return diff(resistance.decel, base.decel) + diff(resistance.period, base.period);
+}
+
+static double evaluate(const Target_t &target, const NotchTable_t &table, uint32_t *ticks) {
+    NotchTableStore store(table);
+    SpeedControl control(&store);
+    const std::vector<Keyframe_t> &frames = target.frames;
+    uint32_t end_ms = frames.back().time_ms;
+    size_t frame = 0;
+    double sum = 0;
+    uint32_t count = 0;
+
+    control.reset(frames[0].speed);
+    for (uint32_t t = frames[0].time_ms + TICK_PERIOD_MS; t <= end_ms; t += TICK_PERIOD_MS) {
+        control.tick(target.notch, target.resistance);
+
+        while (frame + 1 < frames.size() && frames[frame + 1].time_ms <= t) frame++;
+        double expected = frames[frame].speed;
+        if (frame + 1 < frames.size()) {
+            const Keyframe_t &curr = frames[frame];
+            const Keyframe_t &next = frames[frame + 1];
+            expected += (double)(next.speed - curr.speed) * (t - curr.time_ms) / (next.time_ms - curr.time_ms);
+        }
+
+        double error = control.current_speed_q8() / 256.0 - expected;
+        sum += error * error;
+        count++;
+    }
+
+    *ticks += count;
+    return count > 0 ? sqrt(sum / count) : 0;
+}
+
+static bool isBetter(const Best_t &a, const Best_t &b) {
+    if (a.error != b.error) return a.error < b.error;
+    if (a.distance != b.distance) return a.distance < b.distance;
+    return a.candidate < b.candidate;
+}
+
+static void workerProc(const std::vector<Target_t> *targets, const std::vector<Chunk_t> *chunks,
+                       std::atomic<size_t> *next_chunk, std::vector<Best_t> *best, uint64_t *ticks) {
+    uint32_t local_ticks = 0;
+
+    while (true) {
+        size_t index = next_chunk->fetch_add(1);
+        if (index >= chunks->size()) break;
+
+        const Chunk_t &chunk = (*chunks)[index];
+        const Target_t &target = (*targets)[chunk.target];
+        Best_t &target_best = (*best)[chunk.target];
+
+        for (uint32_t candidate = chunk.begin; candidate < chunk.end; candidate++) {
+            NotchTable_t table = DEFAULT_NOTCH_TABLE;
+            Best_t result;
+            result.distance = applyCandidate(target, candidate, &table);
+            result.candidate = candidate;
+            result.error = evaluate(target, table, &local_ticks);
+            if (isBetter(result, target_best)) target_best = result;
+        }
+
+        *ticks += local_ticks;
+        local_ticks = 0;
+    }
+}
+
+static void periodComment(char *buff, size_t len, uint8_t period, const char *action) {
+    if (period == 1) snprintf(buff, len, "毎ティック%s", action);
+    else snprintf(buff, len, "%dティックに1回%s", period, action);
+}
+
+static void writeTable(FILE *fp, const NotchTable_t &table) {
+    char period[32];
+    char entry[24];
+
+    fprintf(fp, "#ifndef DEFAULT_NOTCH_TABLE_H_" EOL "#define DEFAULT_NOTCH_TABLE_H_" EOL EOL);
+    fprintf(fp, "#include \"SpeedControl.h\"" EOL EOL);
+    fprintf(fp, "// 速度制御の初期テーブル (tools/notch_tuner -o で再生成できる)" EOL);
+    fprintf(fp, "static const NotchTable_t DEFAULT_NOTCH_TABLE = {" EOL);
+
+    fprintf(fp, "  {  // 力行: ノッチ1-5" EOL);
+    for (uint8_t i = 0; i < POWER_NOTCH_NUM; i++) {
+        const PowerNotchInfo_t &p = table.power[i];
+        periodComment(period, sizeof(period), p.period, "加速");
+        snprintf(entry, sizeof(entry), "{%d, %d, %d}%s", p.max_speed, p.base_accel, p.period, i + 1 < POWER_NOTCH_NUM ? "," : "");
+        fprintf(fp, "    %-20s  // ノッチ%d: 最大速度%d, 基本加速度%d, %s" EOL, entry, i + 1, p.max_speed, p.base_accel, period);
+    }
+
+    fprintf(fp, "  }," EOL "  {  // ブレーキ1-8 + 非常" EOL);
+    for (uint8_t i = 0; i < BRAKE_NOTCH_NUM; i++) {
+        const BrakeNotchInfo_t &b = table.brake[i];
+        char name[32];
+        if (i == BRAKE_NOTCH_NUM - 1) snprintf(name, sizeof(name), "非常ブレーキ");
+        else snprintf(name, sizeof(name), "ブレーキ%d", i + 1);
+        periodComment(period, sizeof(period), b.period, "減速");
+        snprintf(entry, sizeof(entry), "{%d, %d}%s", b.period, b.decel, i + 1 < BRAKE_NOTCH_NUM ? "," : "");
+        fprintf(fp, "    %-20s  // %s: %s, 減速度%d" EOL, entry, name, period, b.decel);
+    }
+
+    fprintf(fp, "  }," EOL "  {  // 環境抵抗" EOL);
+    for (uint8_t i = 0; i < ENV_RESISTANCE_NUM; i++) {
+        const EnvironmentResistance_t &r = table.resistance[i];
+        snprintf(entry, sizeof(entry), "{%d, %d}%s", r.decel, r.period, i + 1 < ENV_RESISTANCE_NUM ? "," : "");
+        if (r.decel == 0) {
+            fprintf(fp, "    %-20s  // レベル%d: 抵抗なし" EOL, entry, i);
+        } else {
+            periodComment(period, sizeof(period), r.period, "減速");
+            fprintf(fp, "    %-20s  // レベル%d: %s%d" EOL, entry, i, period, r.decel);
+        }
+    }
+
+    fprintf(fp, "  }" EOL "};" EOL EOL "#endif //DEFAULT_NOTCH_TABLE_H_" EOL);
+}
+
+static bool writeOutput(const char *path, const NotchTable_t &table) {
+    if (path == NULL) {
+        writeTable(stdout, table);
+        return true;
+    }
+
+    FILE *fp = fopen(path, "wb");
+    if (fp == NULL) {
+        fprintf(stderr, "failed to write: %s\n", path);
+        return false;
+    }
+    writeTable(fp, table);
+    fclose(fp);
+    return true;
+}
+
+int main(int argc, char **argv) {
+    const char *targets_path = "tools/notch_tuner/targets.txt";
+    const char *out_path = NULL;
+    unsigned threads = std::thread::hardware_concurrency();
+    bool is_current = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) out_path = argv[++i];
+        else if (strcmp(argv[i], "--current") == 0) is_current = true;
+        else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) threads = atoi(argv[++i]);
+        else targets_path = argv[i];
+    }
+    if (threads == 0) threads = 1;
+
+    NotchTable_t tuned = DEFAULT_NOTCH_TABLE;
+    std::vector<Target_t> targets;
+    if (is_current) return writeOutput(out_path, tuned) ? 0 : 1;
+
+    if (!loadTargets(targets_path, targets)) {
+        fprintf(stderr, "failed to load targets: %s\n", targets_path);
+        return 1;
+    }
+
+    // ノッチ毎の候補を同じ大きさの塊に分けて、空いたスレッドから取っていく
+    std::vector<Chunk_t> chunks;
+    uint64_t total_candidates = 0;
+    for (size_t i = 0; i < targets.size(); i++) {
+        targets[i].candidates = candidateCount(targets[i].kind);
+        total_candidates += targets[i].candidates;
+        for (uint32_t begin = 0; begin < targets[i].candidates; begin += CHUNK_CANDIDATES) {
+            Chunk_t chunk = {i, begin, begin + CHUNK_CANDIDATES};
+            if (chunk.end > targets[i].candidates) chunk.end = targets[i].candidates;
+            chunks.push_back(chunk);
+        }
+    }
+
+    Best_t initial = {INFINITY, UINT32_MAX, UINT32_MAX};
+    std::vector<std::vector<Best_t> > best(threads, std::vector<Best_t>(targets.size(), initial));
+    std::vector<uint64_t> ticks(threads, 0);
+    std::vector<std::thread> workers;
+    std::atomic<size_t> next_chunk(0);
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (unsigned i = 0; i < threads; i++) {
+        workers.push_back(std::thread(workerProc, &targets, &chunks, &next_chunk, &best[i], &ticks[i]));
+    }
+    for (unsigned i = 0; i < threads; i++) {
+        workers[i].join();
+    }
+    double wall_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    uint64_t total_ticks = 0;
+    for (unsigned i = 0; i < threads; i++) total_ticks += ticks[i];
+
+    fprintf(stderr, "notch  frames  current(rms)  tuned(rms)  change\n");
+    for (size_t t = 0; t < targets.size(); t++) {
+        Best_t result = best[0][t];
+        for (unsigned i = 1; i < threads; i++) {
+            if (isBetter(best[i][t], result)) result = best[i][t];
+        }
+
+        uint32_t dummy = 0;
+        double current_error = evaluate(targets[t], DEFAULT_NOTCH_TABLE, &dummy);
+        applyCandidate(targets[t], result.candidate, &tuned);
+        fprintf(stderr, "%-5s  %6zu  %12.2f  %10.2f  %6u\n", targets[t].name.c_str(), targets[t].frames.size(),
+                current_error, result.error, result.distance);
+    }
+    fprintf(stderr, "%llu candidates / %llu ticks on %u threads in %.1f ms (%.1f M ticks/s)\n",
+            (unsigned long long)total_candidates, (unsigned long long)total_ticks, threads, wall_ms,
+            total_ticks / wall_ms / 1000.0);
+
+    return writeOutput(out_path, tuned) ? 0 : 1;
+}
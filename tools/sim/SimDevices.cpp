@@ -0,0 +1,413 @@
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "hal/Hal.h"
+#include "hal/PosixHal.h"
+#include "MasterController.h"
+#include "SimDevices.h"
+
+#define HID_REPORT_SIZE             8
+#define POINT_CHANNEL_LEFT          2
+#define POINT_CHANNEL_RIGHT         3
+#define SHORT_CURRENT_MA            3000
+
+// HIDレポート内の位置 (X: ボタン, Y: 追加ボタン, Z1: ハット, Rz: ハンドル)
+#define REPORT_BUTTON               0
+#define REPORT_ADDITIONAL_BUTTON    1
+#define REPORT_HAT                  2
+#define REPORT_HANDLE               4
+
+typedef enum {
+    OP_SET,
+    OP_PRESS,
+    OP_RELEASE,
+    OP_SHORT,
+    OP_END,
+} ScenarioOp_t;
+
+typedef struct {
+    uint32_t time_ms;
+    ScenarioOp_t op;
+    uint8_t index;
+    uint8_t value;
+} ScenarioStep_t;
+
+typedef struct {
+    const char *name;
+    uint8_t value;
+} NamedValue_t;
+
+static const NamedValue_t HANDLE_NAMES[] = {
+    {"EB", EmergencyBrake},
+    {"B8", Brake8}, {"B7", Brake7}, {"B6", Brake6}, {"B5", Brake5},
+    {"B4", Brake4}, {"B3", Brake3}, {"B2", Brake2}, {"B1", Brake1},
+    {"N", Center},
+    {"P1", Power1}, {"P2", Power2}, {"P3", Power3}, {"P4", Power4}, {"P5", Power5},
+};
+
+static const NamedValue_t HAT_NAMES[] = {
+    {"none", None}, {"up", Up}, {"upright", UpRight}, {"right", Right}, {"downright", DownRight},
+    {"down", Down}, {"downleft", DownLeft}, {"left", Left}, {"upleft", UpLeft},
+};
+
+static const NamedValue_t BUTTON_NAMES[] = {
+    {"y", YButton}, {"b", BButton}, {"a", AButton}, {"x", XButton},
+    {"l", LButton}, {"r", RButton}, {"zl", ZLButton}, {"zr", ZRButton},
+};
+
+static const NamedValue_t ADDITIONAL_BUTTON_NAMES[] = {
+    {"minus", Minus}, {"plus", Plus}, {"home", Home}, {"camera", Camera},
+};
+
+static const ScenarioStep_t DEFAULT_SCENARIO[] = {
+    {0, OP_SET, REPORT_HANDLE, EmergencyBrake},
+    {500, OP_SET, REPORT_HAT, Right},
+    {1000, OP_SET, REPORT_HAT, None},
+    {1500, OP_SET, REPORT_HANDLE, Center},
+    {2000, OP_SET, REPORT_HANDLE, Power5},
+    {12000, OP_SET, REPORT_HANDLE, Center},
+    {15000, OP_SET, REPORT_HANDLE, Brake4},
+    {25000, OP_SET, REPORT_HANDLE, Brake8},
+    {28000, OP_END, 0, 0},
+};
+
+static bool findValue(const NamedValue_t *names, size_t count, const char *name, uint8_t *value) {
+    for (size_t i = 0; i < count; i++) {
+        if (strcmp(names[i].name, name) == 0) {
+            *value = names[i].value;
+            return true;
+        }
+    }
+    return false;
+}
+
+#define FIND_VALUE(names, name, value)  findValue(names, sizeof(names) / sizeof(names[0]), name, value)
+
+class SimMotorPort : public hal::MotorPort {
+public:
+    SimMotorPort(): point_pulses_(0), speed_writes_(0), is_shorted_(false) {
+        memset(duty_, 0, sizeof(duty_));
+    }
+
+    virtual bool begin() {
+        return true;
+    }
+
+    virtual bool getFirmwareVersion(uint8_t *version) {
+        *version = 1;
+        return true;
+    }
+
+    virtual uint8_t getAddress() {
+        return 0x24;
+    }
+
+    virtual bool setNormalMode(uint8_t channel) {
+        return true;
+    }
+
+    virtual bool setMotorSpeed(uint8_t channel, int8_t duty) {
+        if (channel >= sizeof(duty_)) return false;
+
+        if (channel == 0) {
+            train_.update(hal::posix::now_us());
+            train_.setDuty(duty);
+            speed_writes_++;
+        } else if ((channel == POINT_CHANNEL_LEFT || channel == POINT_CHANNEL_RIGHT) && duty_[channel] == 0 && duty != 0) {
+            point_pulses_++;
+        }
+        duty_[channel] = duty;
+        return true;
+    }
+
+    // 脱線などで線路が短絡している間は出力に関係なく大電流が流れる
+    virtual bool readCurrent(uint16_t *milliamps) {
+        train_.update(hal::posix::now_us());
+        uint32_t current = (uint32_t)(train_.current() * 1000);
+        if (is_shorted_ && duty_[0] != 0) current += SHORT_CURRENT_MA;
+        *milliamps = current > UINT16_MAX ? UINT16_MAX : current;
+        return true;
+    }
+
+    void setShorted(bool is_shorted) {
+        is_shorted_ = is_shorted;
+    }
+
+    SimTrain &train() {
+        return train_;
+    }
+
+    uint32_t point_pulses() {
+        return point_pulses_;
+    }
+
+    uint32_t speed_writes() {
+        return speed_writes_;
+    }
+
+private:
+    SimTrain train_;
+    int8_t duty_[4];
+    uint32_t point_pulses_;
+    uint32_t speed_writes_;
+    bool is_shorted_;
+};
+
+static SimMotorPort motor_port;
+
+class ScriptedHidSource : public hal::HidSource {
+public:
+    ScriptedHidSource(): handler_(NULL), next_(0) {
+        memset(report_, 0, sizeof(report_));
+        report_[REPORT_HAT] = None;
+        report_[REPORT_HANDLE] = Center;
+    }
+
+    virtual bool begin(hal::HidReportHandler_t handler) {
+        handler_ = handler;
+        return true;
+    }
+
+    virtual void poll() {
+        bool is_changed = false;
+
+        while (next_ < steps_.size() && steps_[next_].time_ms <= hal::millis()) {
+            const ScenarioStep_t &step = steps_[next_++];
+            switch (step.op) {
+                case OP_SET: report_[step.index] = step.value; break;
+                case OP_PRESS: report_[step.index] |= step.value; break;
+                case OP_RELEASE: report_[step.index] &= ~step.value; break;
+                case OP_SHORT: motor_port.setShorted(step.value != 0); continue;
+                case OP_END: break;
+            }
+            is_changed = true;
+        }
+
+        if (is_changed && handler_) handler_(HID_REPORT_SIZE, report_);
+    }
+
+    std::vector<ScenarioStep_t> &steps() {
+        return steps_;
+    }
+
+private:
+    hal::HidReportHandler_t handler_;
+    std::vector<ScenarioStep_t> steps_;
+    size_t next_;
+    uint8_t report_[HID_REPORT_SIZE];
+};
+
+class NullMidiSource : public hal::MidiSource {
+public:
+    virtual bool begin() {
+        return true;
+    }
+
+    virtual bool is_connected() {
+        return false;
+    }
+
+    virtual bool read(uint8_t *buffer, uint16_t *size) {
+        *size = 0;
+        return false;
+    }
+};
+
+// 画面の代わりに最後に描画された値だけを保持する
+class HeadlessDisplay : public hal::DisplaySurface {
+public:
+    HeadlessDisplay(): speed_(0), is_chart_visible_(false) {}
+
+    virtual void begin(int8_t max_speed, NotchTableStore *tables, LocoProfiles_t *profiles) {}
+    virtual void setSpeed(int8_t speed, bool is_push) { speed_ = speed; }
+    virtual void drawRail(bool is_left, bool is_evacute, bool is_push) {}
+    virtual void drawDamp(uint8_t damp) {}
+    virtual void drawTargetStop(bool is_visible, bool is_apply, int8_t notch, uint8_t progress) {}
+    virtual void addChartSample(int8_t speed, int8_t notch, uint8_t damp) {}
+    virtual void setChartVisible(bool is_visible) { is_chart_visible_ = is_visible; }
+    virtual bool is_chart_visible() { return is_chart_visible_; }
+    virtual void poll() {}
+
+    int8_t speed() {
+        return speed_;
+    }
+
+private:
+    int8_t speed_;
+    bool is_chart_visible_;
+};
+
+// 115200bpsのUARTの代わりにファイルへ書く (送信FIFOの空きは仮想時刻で増える)
+class SimTelemetryPort : public hal::TelemetryPort {
+public:
+    static const uint32_t BYTES_PER_SEC = 115200 / 10;
+    static const uint32_t FIFO_SIZE = 128;
+
+    SimTelemetryPort(): fp_(NULL), last_us_(0), credit_(0), bytes_(0) {}
+
+    bool open(const char *path) {
+        fp_ = fopen(path, "wb");
+        last_us_ = hal::posix::now_us();
+        credit_ = FIFO_SIZE;
+        return fp_ != NULL;
+    }
+
+    void close() {
+        if (fp_ != NULL) fclose(fp_);
+        fp_ = NULL;
+    }
+
+    virtual bool is_enabled() {
+        return fp_ != NULL;
+    }
+
+    virtual size_t writable() {
+        // 1バイト未満の端数は次回へ持ち越す
+        uint64_t bytes = (hal::posix::now_us() - last_us_) * BYTES_PER_SEC / 1000000;
+        last_us_ += bytes * 1000000 / BYTES_PER_SEC;
+        credit_ = bytes + credit_ > FIFO_SIZE ? FIFO_SIZE : bytes + credit_;
+        return credit_;
+    }
+
+    virtual size_t write(const uint8_t *data, size_t len) {
+        if (fp_ == NULL) return 0;
+        if (len > credit_) len = credit_;
+        credit_ -= len;
+        bytes_ += len;
+        return fwrite(data, 1, len, fp_);
+    }
+
+    uint32_t bytes() {
+        return bytes_;
+    }
+
+private:
+    FILE *fp_;
+    uint64_t last_us_;
+    uint32_t credit_;
+    uint32_t bytes_;
+};
+
+static ScriptedHidSource hid_source;
+static NullMidiSource midi_source;
+static HeadlessDisplay headless_display;
+static SimTelemetryPort telemetry_port;
+
+namespace hal {
+
+MotorPort &motorPort() {
+    return motor_port;
+}
+
+HidSource &hidSource() {
+    return hid_source;
+}
+
+MidiSource &midiSource() {
+    return midi_source;
+}
+
+DisplaySurface &displaySurface() {
+    return headless_display;
+}
+
+TelemetryPort &telemetryPort() {
+    return telemetry_port;
+}
+
+// 電源のモデルは持たない
+bool readBatteryCurrent(int32_t *milliamps) {
+    return false;
+}
+
+}
+
+namespace sim {
+
+SimTrain &train() {
+    return motor_port.train();
+}
+
+uint32_t pointPulses() {
+    return motor_port.point_pulses();
+}
+
+uint32_t speedWrites() {
+    return motor_port.speed_writes();
+}
+
+int8_t displayedSpeed() {
+    return headless_display.speed();
+}
+
+bool openTelemetry(const char *path) {
+    return telemetry_port.open(path);
+}
+
+void closeTelemetry() {
+    telemetry_port.close();
+}
+
+uint32_t telemetryBytes() {
+    return telemetry_port.bytes();
+}
+
+bool loadScenario(const char *path) {
+    FILE *fp = fopen(path, "r");
+    if (fp == NULL) return false;
+
+    std::vector<ScenarioStep_t> &steps = hid_source.steps();
+    char line[128];
+    uint32_t line_no = 0;
+    bool is_ok = true;
+
+    steps.clear();
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        char op[16];
+        char arg[16] = "";
+        ScenarioStep_t step;
+
+        line_no++;
+        if (line[0] == '#') continue;
+        if (sscanf(line, "%u %15s %15s", &step.time_ms, op, arg) < 2) continue;
+
+        bool is_button = strcmp(op, "press") == 0 || strcmp(op, "release") == 0;
+        step.op = is_button ? (op[0] == 'p' ? OP_PRESS : OP_RELEASE) : OP_SET;
+        if (strcmp(op, "handle") == 0 && FIND_VALUE(HANDLE_NAMES, arg, &step.value)) {
+            step.index = REPORT_HANDLE;
+        } else if (strcmp(op, "hat") == 0 && FIND_VALUE(HAT_NAMES, arg, &step.value)) {
+            step.index = REPORT_HAT;
+        } else if (is_button && FIND_VALUE(BUTTON_NAMES, arg, &step.value)) {
+            step.index = REPORT_BUTTON;
+        } else if (is_button && FIND_VALUE(ADDITIONAL_BUTTON_NAMES, arg, &step.value)) {
+            step.index = REPORT_ADDITIONAL_BUTTON;
+        } else if (strcmp(op, "short") == 0 && (strcmp(arg, "on") == 0 || strcmp(arg, "off") == 0)) {
+            step.op = OP_SHORT;
+            step.index = 0;
+            step.value = strcmp(arg, "on") == 0;
+        } else if (strcmp(op, "end") == 0) {
+            step.op = OP_END;
+            step.index = 0;
+            step.value = 0;
+        } else {
+            fprintf(stderr, "%s:%u: unknown step: %s", path, line_no, line);
+            is_ok = false;
+            continue;
+        }
+        steps.push_back(step);
+    }
+
+    fclose(fp);
+    return is_ok && steps.size() > 0;
+}
+
+void useDefaultScenario() {
+    hid_source.steps().assign(DEFAULT_SCENARIO, DEFAULT_SCENARIO + sizeof(DEFAULT_SCENARIO) / sizeof(DEFAULT_SCENARIO[0]));
+}
+
+uint32_t scenarioEndMs() {
+    std::vector<ScenarioStep_t> &steps = hid_source.steps();
+    return steps.empty() ? 0 : steps.back().time_ms;
+}
+
+}
@@ -0,0 +1,27 @@
+#ifndef SIM_DEVICES_H_
+#define SIM_DEVICES_H_
+
+#include <stdint.h>
+#include "SimTrain.h"
+
+// シミュレーター側からデバイスの状態を操作・参照する
+namespace sim {
+
+SimTrain &train();
+uint32_t pointPulses();
+uint32_t speedWrites();
+int8_t displayedSpeed();
+
+// テレメトリをファイルへ書く (115200bps相当の速さで)
+bool openTelemetry(const char *path);
+void closeTelemetry();
+uint32_t telemetryBytes();
+
+// マスコン操作のシナリオ (1行1操作 "<時刻ms> <操作> <値>")
+bool loadScenario(const char *path);
+void useDefaultScenario();
+uint32_t scenarioEndMs();
+
+}
+
+#endif //SIM_DEVICES_H_
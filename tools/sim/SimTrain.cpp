@@ -0,0 +1,53 @@
+#include <math.h>
+#include "SimTrain.h"
+
+const float SimTrain::DEAD_ZONE = 12.0f;        // この値までは起動しない (PWM値)
+const float SimTrain::GAIN = 3.0f;              // PWM値1あたりの定常速度 (mm/s)
+const float SimTrain::TIME_CONSTANT_S = 0.4f;
+const float SimTrain::STALL_CURRENT = 0.30f;    // 停止中にPWM最大を掛けた時の電流 (A)
+const float SimTrain::RUN_CURRENT = 0.08f;      // 定常走行時の電流 (A)
+
+SimTrain::SimTrain():
+    duty_(0),
+    velocity_(0),
+    position_(0),
+    last_us_(0) {
+
+}
+
+void SimTrain::setDuty(int8_t duty) {
+    duty_ = duty;
+}
+
+void SimTrain::update(uint64_t now_us) {
+    float dt = (now_us - last_us_) / 1000000.0f;
+    last_us_ = now_us;
+    if (dt <= 0) return;
+
+    float magnitude = fabsf((float)duty_) - DEAD_ZONE;
+    float target = magnitude > 0 ? magnitude * GAIN : 0;
+    if (duty_ < 0) target = -target;
+
+    velocity_ += (target - velocity_) * (1.0f - expf(-dt / TIME_CONSTANT_S));
+    position_ += velocity_ * dt;
+}
+
+int8_t SimTrain::duty() {
+    return duty_;
+}
+
+float SimTrain::velocity() {
+    return velocity_;
+}
+
+float SimTrain::position() {
+    return position_;
+}
+
+float SimTrain::current() {
+    // 逆起電力の分だけ電流が減る
+    float load = fabsf((float)duty_) / 127.0f;
+    float back_emf = fabsf(velocity_) / (127.0f * GAIN);
+    float amps = load * STALL_CURRENT - back_emf * (STALL_CURRENT - RUN_CURRENT);
+    return amps > 0 ? amps : 0;
+}
@@ -0,0 +1,33 @@
+#ifndef SIM_TRAIN_H_
+#define SIM_TRAIN_H_
+
+#include <stdint.h>
+
+// PWM値から車両の速度・位置・電流を求める簡易モデル
+// (デッドゾーン付きの一次遅れ。速度はmm/s、位置はmm)
+class SimTrain {
+public:
+    SimTrain();
+
+    void setDuty(int8_t duty);
+    void update(uint64_t now_us);
+
+    int8_t duty();
+    float velocity();
+    float position();
+    float current();
+
+private:
+    static const float DEAD_ZONE;
+    static const float GAIN;
+    static const float TIME_CONSTANT_S;
+    static const float STALL_CURRENT;
+    static const float RUN_CURRENT;
+
+    int8_t duty_;
+    float velocity_;
+    float position_;
+    uint64_t last_us_;
+};
+
+#endif //SIM_TRAIN_H_
@@ -0,0 +1,98 @@
+// 実機なしでアプリ本体(App.cpp)を動かすシミュレーター
+//
+//   pio run -e native_sim
+//   .pio/build/native_sim/program [scenario.txt] [--trace trace.csv] [--telemetry out.bin] [--warm] [--quiet]
+//
+// 時刻は仮想時刻で進めるので、同じシナリオからは毎回同じ結果になる。
+// シナリオは1行1操作 "<時刻ms> <操作> <値>" (tools/sim/scenarios/ を参照)。
+//   handle EB|B8..B1|N|P1..P5 / hat none|up|upright|... / press|release <ボタン> / short on|off / end
+// --telemetry は実機のシリアルと同じフレームを115200bps相当の速さで書く (tools/telemetry/decode.py で読む)。
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <sys/resource.h>
+#include "App.h"
+#include "hal/Hal.h"
+#include "hal/PosixHal.h"
+#include "SimDevices.h"
+
+static const uint32_t LOOP_INTERVAL_US = 1000;
+static const uint32_t TRACE_INTERVAL_MS = 50;
+
+int main(int argc, char **argv) {
+    const char *scenario_path = NULL;
+    const char *trace_path = NULL;
+    const char *telemetry_path = NULL;
+    bool is_warm = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) trace_path = argv[++i];
+        else if (strcmp(argv[i], "--telemetry") == 0 && i + 1 < argc) telemetry_path = argv[++i];
+        else if (strcmp(argv[i], "--warm") == 0) is_warm = true;
+        else if (strcmp(argv[i], "--quiet") == 0) hal::posix::setLogEnabled(false);
+        else scenario_path = argv[i];
+    }
+
+    if (scenario_path != NULL) {
+        if (!sim::loadScenario(scenario_path)) {
+            fprintf(stderr, "failed to load scenario: %s\n", scenario_path);
+            return 1;
+        }
+    } else {
+        sim::useDefaultScenario();
+    }
+
+    FILE *trace = NULL;
+    if (trace_path != NULL) {
+        trace = fopen(trace_path, "w");
+        if (trace == NULL) {
+            fprintf(stderr, "failed to open: %s\n", trace_path);
+            return 1;
+        }
+        fprintf(trace, "time_ms,speed,duty,velocity_mm_s,position_mm,current_a\n");
+    }
+
+    if (telemetry_path != NULL && !sim::openTelemetry(telemetry_path)) {
+        fprintf(stderr, "failed to open: %s\n", telemetry_path);
+        return 1;
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    SimTrain &train = sim::train();
+    uint32_t end_ms = sim::scenarioEndMs();
+    float max_velocity = 0;
+
+    hal::posix::setWarmReset(is_warm);
+    appSetup();
+
+    while (hal::millis() < end_ms) {
+        appLoop();
+        hal::posix::advance(LOOP_INTERVAL_US);
+        train.update(hal::posix::now_us());
+
+        if (train.velocity() > max_velocity) max_velocity = train.velocity();
+        if (trace != NULL && hal::millis() % TRACE_INTERVAL_MS == 0) {
+            fprintf(trace, "%u,%d,%d,%.1f,%.1f,%.3f\n", hal::millis(), sim::displayedSpeed(), train.duty(),
+                    train.velocity(), train.position(), train.current());
+        }
+    }
+
+    double wall_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    if (trace != NULL) fclose(trace);
+    sim::closeTelemetry();
+
+    printf("simulated %u ms in %.1f ms (x%.0f)\n", end_ms, wall_ms, end_ms / wall_ms);
+    printf("final: speed %d / position %.1f mm / max velocity %.1f mm/s / point pulses %u\n",
+           sim::displayedSpeed(), train.position(), max_velocity, sim::pointPulses());
+    printf("power save: %.1f s\n", hal::posix::powerSaveUs() / 1000000.0);
+    printf("speed writes: %u (%.1f /s)\n", sim::speedWrites(), sim::speedWrites() * 1000.0 / end_ms);
+    if (telemetry_path != NULL) {
+        printf("telemetry: %u bytes (%.0f B/s), dropped %u\n", sim::telemetryBytes(),
+               sim::telemetryBytes() * 1000.0 / end_ms, telemetry.dropped());
+    }
+    printf("max rss: %ld KB\n", usage.ru_maxrss);
+    return 0;
+}
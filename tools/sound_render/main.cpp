@@ -0,0 +1,164 @@
+// TractionSoundをオフラインでWAVに書き出す (回帰確認 / ブロック毎の処理時間計測用)
+//
+//   pio run -e sound_render
+//   .pio/build/sound_render/program [out.wav] [scenario.txt]
+//
+// 出力を省略するとビルドの出力先 (.pio/build/sound_render/traction.wav) に書く。
+// シナリオは1行1キーフレーム "<時刻ms> <速度> <ノッチ>"。
+// 速度はキーフレーム間で線形補間し、ノッチは次のキーフレームまで保持する。
+// 既定のシナリオでは波形のハッシュを EXPECTED_HASH と比べ、違えば終了コード1で終わる
+// (音を意図して変えた時は表示されたハッシュで EXPECTED_HASH を更新する)。
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+#include "TractionSound.h"
+
+#define DEFAULT_OUT_PATH            ".pio/build/sound_render/traction.wav"
+
+// 既定のシナリオを描いた波形のハッシュ
+static const uint32_t EXPECTED_HASH = 0xc8a6b810u;
+
+typedef struct {
+    uint32_t time_ms;
+    int speed;
+    int notch;
+} Keyframe_t;
+
+static const Keyframe_t DEFAULT_SCENARIO[] = {
+    {0, 0, -8},         // 停車 (ブレーキ8)
+    {1000, 0, 5},       // 緩解してノッチ5
+    {11000, 85, 5},
+    {13000, 85, 0},     // 惰行
+    {14000, 83, -4},    // ブレーキ4
+    {22000, 0, -4},
+    {23000, 0, 0},      // 緩解
+    {25000, 0, 0},
+};
+
+static void putLe16(FILE *fp, uint16_t v) {
+    uint8_t b[2] = {(uint8_t)v, (uint8_t)(v >> 8)};
+    fwrite(b, 1, 2, fp);
+}
+
+static void putLe32(FILE *fp, uint32_t v) {
+    uint8_t b[4] = {(uint8_t)v, (uint8_t)(v >> 8), (uint8_t)(v >> 16), (uint8_t)(v >> 24)};
+    fwrite(b, 1, 4, fp);
+}
+
+static bool writeWav(const char *path, const std::vector<int16_t> &pcm, uint32_t rate) {
+    FILE *fp = fopen(path, "wb");
+    if (fp == NULL) return false;
+
+    uint32_t data_size = pcm.size() * sizeof(int16_t);
+    fwrite("RIFF", 1, 4, fp);
+    putLe32(fp, 36 + data_size);
+    fwrite("WAVEfmt ", 1, 8, fp);
+    putLe32(fp, 16);
+    putLe16(fp, 1);             // PCM
+    putLe16(fp, 1);             // モノラル
+    putLe32(fp, rate);
+    putLe32(fp, rate * sizeof(int16_t));
+    putLe16(fp, sizeof(int16_t));
+    putLe16(fp, 16);
+    fwrite("data", 1, 4, fp);
+    putLe32(fp, data_size);
+    for (size_t i = 0; i < pcm.size(); i++) {
+        putLe16(fp, (uint16_t)pcm[i]);
+    }
+
+    fclose(fp);
+    return true;
+}
+
+static bool loadScenario(const char *path, std::vector<Keyframe_t> &frames) {
+    FILE *fp = fopen(path, "r");
+    if (fp == NULL) return false;
+
+    char line[128];
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        Keyframe_t frame;
+        if (line[0] == '#') continue;
+        if (sscanf(line, "%u %d %d", &frame.time_ms, &frame.speed, &frame.notch) == 3) {
+            frames.push_back(frame);
+        }
+    }
+
+    fclose(fp);
+    return frames.size() > 0;
+}
+
+int main(int argc, char **argv) {
+    const char *out_path = argc > 1 ? argv[1] : DEFAULT_OUT_PATH;
+    std::vector<Keyframe_t> frames;
+    bool is_default_scenario = argc <= 2;
+
+    if (!is_default_scenario) {
+        if (!loadScenario(argv[2], frames)) {
+            fprintf(stderr, "failed to load scenario: %s\n", argv[2]);
+            return 1;
+        }
+    } else {
+        frames.assign(DEFAULT_SCENARIO, DEFAULT_SCENARIO + sizeof(DEFAULT_SCENARIO) / sizeof(DEFAULT_SCENARIO[0]));
+    }
+
+    const uint32_t rate = TRACTION_SOUND_SAMPLE_RATE;
+    const uint32_t block_ms = TRACTION_SOUND_BLOCK_SAMPLES * 1000 / rate;
+    TractionSound sound(rate);
+    std::vector<int16_t> pcm;
+    int16_t block[TRACTION_SOUND_BLOCK_SAMPLES];
+
+    uint64_t total_ns = 0;
+    uint64_t max_ns = 0;
+    uint32_t blocks = 0;
+    size_t frame = 0;
+    uint32_t end_ms = frames.back().time_ms;
+
+    for (uint32_t t = 0; t < end_ms; t += block_ms) {
+        while (frame + 1 < frames.size() && frames[frame + 1].time_ms <= t) frame++;
+
+        const Keyframe_t &curr = frames[frame];
+        int speed = curr.speed;
+        if (frame + 1 < frames.size()) {
+            const Keyframe_t &next = frames[frame + 1];
+            speed += (next.speed - curr.speed) * (int)(t - curr.time_ms) / (int)(next.time_ms - curr.time_ms);
+        }
+        sound.setState((int8_t)speed, (int8_t)curr.notch);
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        sound.render(block, TRACTION_SOUND_BLOCK_SAMPLES);
+        uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+        total_ns += ns;
+        if (ns > max_ns) max_ns = ns;
+        blocks++;
+        pcm.insert(pcm.end(), block, block + TRACTION_SOUND_BLOCK_SAMPLES);
+    }
+
+    // 回帰確認用のハッシュ (FNV-1a)
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < pcm.size(); i++) {
+        hash = (hash ^ (uint16_t)pcm[i]) * 16777619u;
+    }
+
+    if (!writeWav(out_path, pcm, rate)) {
+        fprintf(stderr, "failed to write: %s\n", out_path);
+        return 1;
+    }
+
+    printf("wrote %s: %u blocks x %u samples @ %u Hz\n", out_path, blocks, TRACTION_SOUND_BLOCK_SAMPLES, rate);
+    printf("render: avg %llu ns / max %llu ns per block (budget %u ms)\n",
+           (unsigned long long)(total_ns / blocks), (unsigned long long)max_ns, block_ms);
+    if (!is_default_scenario) {
+        printf("hash: %08x\n", hash);
+        return 0;
+    }
+
+    if (hash != EXPECTED_HASH) {
+        printf("hash: %08x (expected %08x) MISMATCH\n", hash, EXPECTED_HASH);
+        return 1;
+    }
+    printf("hash: %08x ok\n", hash);
+    return 0;
+}
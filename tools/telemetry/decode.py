@@ -0,0 +1,217 @@
+#!/usr/bin/env python3
+"""シリアルのテレメトリ(バイナリのフレーム)をCSV/Parquetに変換する。
+
+    python3 tools/telemetry/decode.py /dev/ttyUSB0 -o run.csv [--baud 115200] [--plot]
+    python3 tools/telemetry/decode.py telemetry.bin -o run.parquet
+
+入力はシリアルポート(pyserial)か、シミュレーターの --telemetry で書いたファイル。
+フレームは 0x00 で区切った COBS([種別][記録][CRC16]) (include/Telemetry.h を参照)。
+ログのフレーム (hal::log() の行) は標準エラーに表示する。
+CRCの合わないフレームのうち表示できる文字だけのもの (テレメトリの送信を始める前の出力) もログとして表示する。
+Parquetは pandas + pyarrow、--plot は matplotlib を使う。
+"""
+import argparse
+import csv
+import os
+import struct
+import sys
+import time
+
+TYPE_TICK = 0x01
+TYPE_LOG = 0x02
+
+# TelemetryTick_t (リトルエンディアン, パディングなし)
+TICK_FORMAT = '<IHbbbbbBBHHh'
+TICK_FIELDS = ['time_ms', 'seq', 'speed', 'target', 'allowed', 'handle_notch', 'notch',
+               'resistance', 'flags', 'current_ma', 'i2c_us', 'jitter_us']
+TICK_SIZE = struct.calcsize(TICK_FORMAT)
+
+FLAG_NAMES = [(0x01, 'feeder_cut'), (0x02, 'atp_enabled'), (0x04, 'atp_active'),
+              (0x08, 'tasc_apply'), (0x10, 'emergency'), (0x80, 'dropped')]
+
+PLOT_WINDOW = 400       # 表示するティック数 (50ms x 400 = 20秒)
+
+
+def crc16_ccitt(data, crc=0xFFFF):
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+def cobs_decode(data):
+    out = bytearray()
+    pos = 0
+    while pos < len(data):
+        code = data[pos]
+        if code == 0 or pos + code > len(data):
+            return None
+        out += data[pos + 1:pos + code]
+        pos += code
+        if code < 0xFF and pos < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+class Decoder:
+    """受け取ったバイト列をフレームに分け、記録(dict)を返す。"""
+
+    def __init__(self, log=sys.stderr):
+        self.buffer = bytearray()
+        self.log = log
+        self.frames = 0
+        self.errors = 0
+        self.last_seq = None
+        self.lost = 0
+
+    def feed(self, data):
+        records = []
+        self.buffer += data
+        while True:
+            end = self.buffer.find(b'\x00')
+            if end < 0:
+                break
+            chunk = bytes(self.buffer[:end])
+            del self.buffer[:end + 1]
+            if chunk:
+                record = self.frame(chunk)
+                if record is not None:
+                    records.append(record)
+        return records
+
+    def frame(self, chunk):
+        raw = cobs_decode(chunk)
+        if raw is None or len(raw) < 3 or crc16_ccitt(raw[:-2]) != struct.unpack('<H', raw[-2:])[0]:
+            self.text(chunk)
+            return None
+
+        kind, payload = raw[0], raw[1:-2]
+        if kind == TYPE_LOG:
+            self.frames += 1
+            self.print_log(payload.decode('utf-8', 'replace'))
+            return None
+        if kind != TYPE_TICK or len(payload) != TICK_SIZE:
+            self.errors += 1
+            return None
+
+        self.frames += 1
+        record = dict(zip(TICK_FIELDS, struct.unpack(TICK_FORMAT, payload)))
+        if self.last_seq is not None:
+            self.lost += (record['seq'] - self.last_seq - 1) & 0xFFFF
+        self.last_seq = record['seq']
+        for bit, name in FLAG_NAMES:
+            record[name] = int(bool(record['flags'] & bit))
+        return record
+
+    def text(self, chunk):
+        # テレメトリを始める前のログはフレームにならずに届く
+        if all(0x20 <= b < 0x7F or b in b'\r\n\t' for b in chunk):
+            self.print_log(chunk.decode('ascii'))
+        else:
+            self.errors += 1
+
+    def print_log(self, text):
+        for line in text.splitlines():
+            if line.strip():
+                print(f'log: {line}', file=self.log)
+
+
+def open_source(path, baud):
+    if os.path.exists(path) and not path.startswith('/dev/') and not path.upper().startswith('COM'):
+        return open(path, 'rb'), False
+    import serial
+    return serial.Serial(path, baud, timeout=0.1), True
+
+
+def read_chunks(source, is_serial):
+    while True:
+        data = source.read(4096) if not is_serial else source.read(max(1, source.in_waiting))
+        if not data:
+            if is_serial:
+                yield b''
+                continue
+            return
+        yield data
+
+
+class LivePlot:
+    def __init__(self):
+        import matplotlib.pyplot as plt
+        self.plt = plt
+        plt.ion()
+        self.fig, (self.ax_speed, self.ax_timing) = plt.subplots(2, 1, sharex=True)
+        self.rows = []
+        self.last_draw = 0
+
+    def add(self, records):
+        self.rows = (self.rows + records)[-PLOT_WINDOW:]
+        if not self.rows or time.monotonic() - self.last_draw < 0.2:
+            return
+        self.last_draw = time.monotonic()
+
+        t = [r['time_ms'] / 1000 for r in self.rows]
+        self.ax_speed.cla()
+        self.ax_speed.plot(t, [r['speed'] for r in self.rows], label='speed')
+        self.ax_speed.plot(t, [r['target'] for r in self.rows], label='target', linestyle=':')
+        self.ax_speed.plot(t, [r['allowed'] for r in self.rows], label='allowed', linestyle='--')
+        self.ax_speed.step(t, [r['notch'] * 10 for r in self.rows], label='notch x10', where='post')
+        self.ax_speed.legend(loc='upper left')
+        self.ax_timing.cla()
+        self.ax_timing.plot(t, [r['i2c_us'] for r in self.rows], label='i2c us')
+        self.ax_timing.plot(t, [r['jitter_us'] for r in self.rows], label='jitter us')
+        self.ax_timing.set_xlabel('time [s]')
+        self.ax_timing.legend(loc='upper left')
+        self.plt.pause(0.001)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('source', help='シリアルポートまたはファイル')
+    parser.add_argument('-o', '--output', help='出力先 (.csv / .parquet, 省略時は標準出力にCSV)')
+    parser.add_argument('--baud', type=int, default=115200)
+    parser.add_argument('--plot', action='store_true', help='受信しながらグラフを表示する')
+    args = parser.parse_args()
+
+    source, is_serial = open_source(args.source, args.baud)
+    decoder = Decoder()
+    plot = LivePlot() if args.plot else None
+    columns = TICK_FIELDS + [name for _, name in FLAG_NAMES]
+    is_parquet = args.output is not None and args.output.endswith('.parquet')
+    rows = []
+
+    out = None
+    if not is_parquet:
+        out = open(args.output, 'w', newline='') if args.output else sys.stdout
+        writer = csv.DictWriter(out, fieldnames=columns)
+        writer.writeheader()
+
+    try:
+        for data in read_chunks(source, is_serial):
+            records = decoder.feed(data)
+            if is_parquet:
+                rows += records
+            else:
+                writer.writerows(records)
+                if is_serial:
+                    out.flush()
+            if plot is not None:
+                plot.add(records)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        source.close()
+
+    if is_parquet:
+        import pandas
+        pandas.DataFrame(rows, columns=columns).to_parquet(args.output, index=False)
+    elif args.output:
+        out.close()
+
+    print(f'frames {decoder.frames} / lost {decoder.lost} / errors {decoder.errors}', file=sys.stderr)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())